@@ -0,0 +1,300 @@
+#pragma once
+#ifndef _BENCH_H
+#define _BENCH_H
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <regex>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <algorithm>
+#include <thread>
+
+/**
+ * @brief A small microbenchmark harness in the style of Google Benchmark.
+ *        Every benchmark runs its loop with a growing number of iterations
+ *        until it takes at least the minimum time, and reports real and CPU
+ *        time per iteration. Options and JSON output follow Google
+ *        Benchmark, so its tools can compare two result files:
+ *
+ *        --benchmark_filter=REGEX      Run benchmarks with matching name
+ *        --benchmark_min_time=SECONDS  Minimum time of a benchmark (0.2)
+ *        --benchmark_format=FORMAT     console or json, for stdout
+ *        --benchmark_out=FILE          Also write JSON to file
+ *        --benchmark_list_tests        Print names of benchmarks
+ */
+namespace gene
+{
+    namespace bench
+    {
+        /**
+         * @brief State of a benchmark run, the loop of benchmark runs
+         *        while keepRunning() is true
+         */
+        class State
+        {
+        private:
+            size_t iterations;
+            size_t done;
+            double bytes;
+            double items;
+
+        public:
+            explicit State(size_t iterations)
+                : iterations(iterations), done(0), bytes(0), items(0) {}
+            /**
+             * @brief Check if loop has another iteration
+             *
+             * @return true
+             * @return false
+             */
+            bool keepRunning()
+            {
+                return this->done++ < this->iterations;
+            }
+            /**
+             * @brief Set bytes processed by all iterations
+             *
+             * @param n
+             */
+            void setBytesProcessed(double n)
+            {
+                this->bytes = n;
+            }
+            /**
+             * @brief Set items processed by all iterations
+             *
+             * @param n
+             */
+            void setItemsProcessed(double n)
+            {
+                this->items = n;
+            }
+            size_t getIterations() const
+            {
+                return this->iterations;
+            }
+            double getBytes() const
+            {
+                return this->bytes;
+            }
+            double getItems() const
+            {
+                return this->items;
+            }
+        };
+
+        using Function = std::function<void(State &)>;
+
+        /**
+         * @brief Result of a benchmark, times are per iteration in ns
+         */
+        struct Result
+        {
+            std::string name;
+            size_t iterations;
+            double realTime;
+            double cpuTime;
+            double bytesPerSecond;
+            double itemsPerSecond;
+        };
+
+        /**
+         * @brief Registered benchmarks and their runner
+         */
+        class Runner
+        {
+        private:
+            std::vector<std::pair<std::string, Function>> benchmarks;
+
+            /**
+             * @brief Run a benchmark with growing iterations, until it runs
+             *        at least min_time
+             *
+             * @param name
+             * @param func
+             * @param min_time
+             * @return Result
+             */
+            static Result measure(const std::string &name, const Function &func, double min_time)
+            {
+                size_t iterations = 1;
+                for (;;)
+                {
+                    State state(iterations);
+                    auto start = std::chrono::steady_clock::now();
+                    auto cpu_start = std::clock();
+                    func(state);
+                    double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+                    std::chrono::duration<double> real = std::chrono::steady_clock::now() - start;
+                    if (real.count() >= min_time || iterations >= 1000000000)
+                        return {name, iterations, real.count() * 1e9 / iterations, cpu * 1e9 / iterations,
+                                state.getBytes() / real.count(), state.getItems() / real.count()};
+                    // Same growth as Google Benchmark: aim 40% past min_time, at most 10x
+                    double scale = real.count() > 0 ? min_time * 1.4 / real.count() : 10;
+                    iterations = std::max(iterations + 1, size_t(iterations * std::min(scale, 10.0)));
+                }
+            }
+
+            /**
+             * @brief Print a string as JSON string
+             *
+             * @param out
+             * @param s
+             */
+            static void writeString(std::ostream &out, const std::string &s)
+            {
+                out << '"';
+                for (auto c : s)
+                    if (c == '"' || c == '\\')
+                        out << '\\' << c;
+                    else
+                        out << c;
+                out << '"';
+            }
+
+            /**
+             * @brief Write results as JSON of Google Benchmark
+             *
+             * @param out
+             * @param executable
+             * @param results
+             */
+            static void writeJson(std::ostream &out, const std::string &executable,
+                                  const std::vector<Result> &results)
+            {
+                char date[32];
+                auto now = std::time(nullptr);
+                std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+                out << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n    \"executable\": ";
+                writeString(out, executable);
+                out << ",\n    \"num_cpus\": " << std::thread::hardware_concurrency()
+#ifdef NDEBUG
+                    << ",\n    \"library_build_type\": \"release\"\n  },\n";
+#else
+                    << ",\n    \"library_build_type\": \"debug\"\n  },\n";
+#endif
+                out << "  \"benchmarks\": [\n" << std::setprecision(10);
+                for (size_t i = 0; i < results.size(); ++i)
+                {
+                    auto &r = results[i];
+                    out << "    {\n      \"name\": ";
+                    writeString(out, r.name);
+                    out << ",\n      \"run_name\": ";
+                    writeString(out, r.name);
+                    out << ",\n      \"run_type\": \"iteration\",\n"
+                        << "      \"iterations\": " << r.iterations << ",\n"
+                        << "      \"real_time\": " << r.realTime << ",\n"
+                        << "      \"cpu_time\": " << r.cpuTime << ",\n"
+                        << "      \"time_unit\": \"ns\"";
+                    if (r.bytesPerSecond > 0)
+                        out << ",\n      \"bytes_per_second\": " << r.bytesPerSecond;
+                    if (r.itemsPerSecond > 0)
+                        out << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+                    out << "\n    }" << (i + 1 < results.size() ? ",\n" : "\n");
+                }
+                out << "  ]\n}\n";
+            }
+
+            /**
+             * @brief Print a result as a line of table
+             *
+             * @param out
+             * @param r
+             */
+            static void writeLine(std::ostream &out, const Result &r)
+            {
+                out << std::left << std::setw(48) << r.name << std::right << std::fixed
+                    << std::setw(16) << std::setprecision(0) << r.realTime
+                    << std::setw(16) << r.cpuTime
+                    << std::setw(12) << r.iterations;
+                if (r.bytesPerSecond > 0)
+                    out << std::setw(12) << std::setprecision(1) << r.bytesPerSecond / 1e6 << " MB/s";
+                if (r.itemsPerSecond > 0)
+                    out << std::setw(12) << std::setprecision(3) << r.itemsPerSecond / 1e6 << " M/s";
+                out << std::endl;
+            }
+
+        public:
+            /**
+             * @brief Register a benchmark
+             *
+             * @param name
+             * @param func
+             */
+            void add(const std::string &name, Function func)
+            {
+                this->benchmarks.emplace_back(name, std::move(func));
+            }
+
+            /**
+             * @brief Run benchmarks selected by options
+             *
+             * @param argc
+             * @param argv
+             * @return int  Exit code
+             */
+            int run(int argc, char **argv)
+            {
+                std::string filter = ".", format = "console", output;
+                double min_time = 0.2;
+                bool list = false;
+                for (int i = 1; i < argc; ++i)
+                {
+                    std::string arg = argv[i];
+                    auto value = arg.substr(arg.find('=') + 1);
+                    if (arg.rfind("--benchmark_filter=", 0) == 0)
+                        filter = value;
+                    else if (arg.rfind("--benchmark_min_time=", 0) == 0)
+                        std::istringstream(value) >> min_time;
+                    else if (arg.rfind("--benchmark_format=", 0) == 0)
+                        format = value;
+                    else if (arg.rfind("--benchmark_out=", 0) == 0)
+                        output = value;
+                    else if (arg == "--benchmark_list_tests")
+                        list = true;
+                }
+                std::regex pattern(filter);
+                std::vector<Result> results;
+                bool console = format != "json";
+                if (console && !list)
+                    std::cout << std::left << std::setw(48) << "Benchmark" << std::right
+                              << std::setw(16) << "Time(ns)" << std::setw(16) << "CPU(ns)"
+                              << std::setw(12) << "Iterations" << std::endl;
+                for (auto &benchmark : this->benchmarks)
+                {
+                    if (!std::regex_search(benchmark.first, pattern))
+                        continue;
+                    if (list)
+                    {
+                        std::cout << benchmark.first << std::endl;
+                        continue;
+                    }
+                    results.push_back(measure(benchmark.first, benchmark.second, min_time));
+                    if (console)
+                        writeLine(std::cout, results.back());
+                }
+                if (list)
+                    return 0;
+                if (!console)
+                    writeJson(std::cout, argv[0], results);
+                if (!output.empty())
+                {
+                    std::ofstream out(output);
+                    writeJson(out, argv[0], results);
+                    if (!out)
+                    {
+                        std::cerr << "Failed to write " << output << std::endl;
+                        return 1;
+                    }
+                }
+                return 0;
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,104 @@
+#include "../src/lib/orf_finder.h"
+#include "../src/lib/codon_kernel.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <sstream>
+
+/**
+ * @brief Microbenchmark of codon detection kernels and ORF scanning
+ *        engines, on a random sequence.
+ */
+
+/**
+ * @brief Run a function repeat times, returns best time in second
+ *
+ * @param repeat
+ * @param func
+ * @return double
+ */
+double best_time(int repeat, const std::function<void()> &func)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = finish - start;
+        best = elapsed.count() < best ? elapsed.count() : best;
+    }
+    return best;
+}
+
+/**
+ * @brief Print one line of result
+ *
+ * @param name
+ * @param seconds
+ * @param bytes
+ */
+void report(const std::string &name, double seconds, size_t bytes)
+{
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000
+              << std::setw(12) << std::setprecision(1) << bytes / seconds / 1e6 << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t length = 10000000;
+    int repeat = 3;
+    if (argc > 1)
+        std::istringstream(argv[1]) >> length;
+    if (argc > 2)
+        std::istringstream(argv[2]) >> repeat;
+
+    // Random DNA sequence
+    std::mt19937 rng(42);
+    std::string data(length, 'A');
+    const char bases[4] = {'A', 'C', 'G', 'T'};
+    for (auto &c : data)
+        c = bases[rng() & 3];
+    Sequence seq("bench", data);
+
+    std::cout << "length=" << length << " repeat=" << repeat
+              << " kernel=" << gene::codon::getKernelName() << std::endl;
+    std::cout << std::left << std::setw(24) << "name"
+              << std::right << std::setw(12) << "ms" << std::setw(12) << "MB/s" << std::endl;
+
+    // Codon detection kernels
+    std::vector<gene::codon::CodonMasks> masks((length + 63) / 64);
+    for (auto name : {"scalar", "sse4.2", "avx2"})
+    {
+        auto kernel = gene::codon::getKernel(name);
+        if (kernel == nullptr)
+            continue;
+        auto t = best_time(repeat, [&]()
+                           { kernel(data.c_str(), length - 2, masks.data()); });
+        report(std::string("kernel/") + name, t, length);
+    }
+
+    // ORF scanning engines, all six frames
+    const std::pair<const char *, gene::ScanMode> modes[] = {
+        {"forward", gene::ScanMode::Forward},
+        {"linear", gene::ScanMode::Linear},
+        {"simd", gene::ScanMode::Simd}};
+    for (auto &mode : modes)
+    {
+        size_t count = 0;
+        auto t = best_time(repeat, [&]()
+                           {
+            count = 0;
+            for (int frame = -3; frame <= 3; ++frame)
+                if (frame != 0)
+                    count += gene::getORFS(seq, frame, 0, length, mode.second).size(); });
+        report(std::string("getORFS/") + mode.first, t, length);
+        std::cout << "    orfs=" << count << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "../src/lib/Fasta.h"
+#include "../src/lib/FastaWriter.h"
+#include "../src/lib/GeneRange.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <cstdio>
+
+/**
+ * @brief Benchmark of gene output, on random ranges of a random sequence.
+ *        It compares the previous output path (string_format, substr and
+ *        std::endl per line), Fasta::write per record, and writeRecords.
+ */
+
+/**
+ * @brief Run a function repeat times, returns best time in second
+ *
+ * @param repeat
+ * @param func
+ * @return double
+ */
+double best_time(int repeat, const std::function<void()> &func)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = finish - start;
+        best = elapsed.count() < best ? elapsed.count() : best;
+    }
+    return best;
+}
+
+/**
+ * @brief Print one line of result
+ *
+ * @param name
+ * @param seconds
+ * @param bytes
+ */
+void report(const std::string &name, double seconds, size_t bytes)
+{
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000
+              << std::setw(12) << std::setprecision(1) << bytes / seconds / 1e6 << std::endl;
+}
+
+/**
+ * @brief Previous label formatting, heap allocated per record
+ *
+ * @tparam Args
+ * @param format
+ * @param args
+ * @return std::string
+ */
+template <typename... Args>
+std::string string_format(const std::string &format, Args... args)
+{
+    int size_s = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;
+    auto size = static_cast<size_t>(size_s);
+    std::unique_ptr<char[]> buf(new char[size]);
+    std::snprintf(buf.get(), size, format.c_str(), args...);
+    return std::string(buf.get(), buf.get() + size - 1);
+}
+
+/**
+ * @brief Previous Fasta::write, a substr and a flush per line
+ *
+ * @param out
+ * @param seq
+ * @param lineWidth
+ */
+void legacy_write(std::ostream &out, const Sequence &seq, size_t lineWidth)
+{
+    out << '>' << seq.getLabel() << std::endl;
+    const auto &sequence = seq.getSequence();
+    for (size_t i = 0; i < sequence.length(); i += lineWidth)
+        out << sequence.substr(i, lineWidth) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 200000;
+    int repeat = 3;
+    std::string path = "fasta_writer_bench.tmp";
+    if (argc > 1)
+        std::istringstream(argv[1]) >> count;
+    if (argc > 2)
+        std::istringstream(argv[2]) >> repeat;
+    if (argc > 3)
+        path = argv[3];
+
+    // Random DNA sequence and gene ranges of 300 to 3000 bases
+    const size_t length = 10000000;
+    const size_t lineWidth = 70;
+    const char *pattern = "%s | gene | frame=%d | LOC=[%d,%d]";
+    std::mt19937 rng(42);
+    std::string data(length, 'A');
+    const char bases[4] = {'A', 'C', 'G', 'T'};
+    for (auto &c : data)
+        c = bases[rng() & 3];
+    Sequence seq("bench", data);
+    std::vector<gene::GeneRange> genes(count);
+    for (auto &g : genes)
+    {
+        unsigned long long start = rng() % (length - 3000);
+        g = {start, start + 300 + rng() % 2700, (int8_t)(rng() % 3 + 1)};
+    }
+
+    size_t bytes = 0;
+    {
+        FastaBuffer out;
+        for (auto &g : genes)
+        {
+            out.appendLabel(pattern, seq.getLabel().c_str(), g.frame, g.start, g.end);
+            out.appendBases(data.data() + g.abs_start(), g.length(), lineWidth);
+            bytes += out.size();
+            out.clear();
+        }
+    }
+    std::cout << "records=" << count << " bytes=" << bytes << " repeat=" << repeat
+              << " threads=" << omp_get_max_threads() << std::endl;
+    std::cout << std::left << std::setw(24) << "name"
+              << std::right << std::setw(12) << "ms" << std::setw(12) << "MB/s" << std::endl;
+
+    auto t = best_time(repeat, [&]()
+                       {
+        std::ofstream out(path);
+        for (auto &g : genes)
+            legacy_write(out, Sequence(string_format(pattern, seq.getLabel().c_str(), g.frame, g.start, g.end),
+                                       data.substr(g.abs_start(), g.length())),
+                         lineWidth); });
+    report("legacy", t, bytes);
+
+    t = best_time(repeat, [&]()
+                  {
+        Fasta out(path.c_str(), std::ios::out);
+        for (auto &g : genes)
+            out.write(Sequence(string_format(pattern, seq.getLabel().c_str(), g.frame, g.start, g.end),
+                               data.substr(g.abs_start(), g.length())),
+                      lineWidth); });
+    report("Fasta::write", t, bytes);
+
+    t = best_time(repeat, [&]()
+                  {
+        Fasta out(path.c_str(), std::ios::out);
+        writeRecords(out, genes.size(), [&](size_t i, FastaBuffer &buffer)
+        {
+            auto &g = genes[i];
+            buffer.appendLabel(pattern, seq.getLabel().c_str(), g.frame, g.start, g.end);
+            buffer.appendBases(data.data() + g.abs_start(), g.length(), lineWidth);
+        }); });
+    report("writeRecords", t, bytes);
+    std::remove(path.c_str());
+    return 0;
+}
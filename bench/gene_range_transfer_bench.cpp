@@ -0,0 +1,173 @@
+#include "../src/lib/GeneRange.h"
+#include "../src/lib/mpi_gene_range.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <functional>
+#include <sstream>
+#include <mpi.h>
+
+/**
+ * @brief Benchmark of GeneRange transfers of gene_finder_mpi: one
+ *        message per range, against one message per transfer, the
+ *        exchange of balance_and_judge (MPI_Alltoall of counts, then
+ *        MPI_Isend and MPI_Irecv of one block per pair of processes,
+ *        received with MPI_Waitany) and MPI_Gatherv for gathering to
+ *        main process.
+ */
+
+MPI_Datatype MPI_GENE_RANGE;
+
+/**
+ * @brief Run a function repeat times on all processes, returns best time
+ *        of the slowest process in second
+ *
+ * @param repeat
+ * @param func
+ * @return double
+ */
+double best_time(int repeat, const std::function<void()> &func)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; ++i)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start = MPI_Wtime();
+        func();
+        double elapsed = MPI_Wtime() - start;
+        MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+/**
+ * @brief Print one line of result on main process
+ *
+ * @param rank
+ * @param name
+ * @param seconds
+ * @param count     Number of ranges transferred
+ */
+void report(int rank, const std::string &name, double seconds, size_t count)
+{
+    if (rank != 0)
+        return;
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000
+              << std::setw(16) << std::setprecision(1) << count / seconds / 1e6 << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int rank, size;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_GENE_RANGE = gene::createGeneRangeType();
+
+    size_t count = 100000;
+    int repeat = 3;
+    if (argc > 1)
+        std::istringstream(argv[1]) >> count;
+    if (argc > 2)
+        std::istringstream(argv[2]) >> repeat;
+    std::vector<gene::GeneRange> ranges(count), received;
+    for (size_t i = 0; i < count; ++i)
+        ranges[i] = {i * 3, i * 3 + 299, (int8_t)(i % 3 + 1)};
+    if (rank == 0)
+    {
+        std::cout << "ranges=" << count << " per process, processes=" << size
+                  << " repeat=" << repeat << std::endl;
+        std::cout << std::left << std::setw(24) << "name"
+                  << std::right << std::setw(12) << "ms" << std::setw(16) << "Mranges/s" << std::endl;
+    }
+
+    // Balancing: even process sends all ranges to next process
+    int peer = rank % 2 == 0 ? rank + 1 : rank - 1;
+    bool paired = peer < size;
+    size_t moved = count * (size / 2);
+    auto t = best_time(repeat, [&]()
+                       {
+        if (!paired)
+            return;
+        gene::GeneRange item;
+        for (size_t i = 0; i < count; ++i)
+            if (rank % 2 == 0)
+                MPI_Send(&ranges[i], 1, MPI_GENE_RANGE, peer, 0, MPI_COMM_WORLD);
+            else
+                MPI_Recv(&item, 1, MPI_GENE_RANGE, peer, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE); });
+    report(rank, "balance/per-range", t, moved);
+    t = best_time(repeat, [&]()
+                  {
+        if (!paired)
+            return;
+        received.resize(count);
+        if (rank % 2 == 0)
+            MPI_Send(ranges.data(), count, MPI_GENE_RANGE, peer, 0, MPI_COMM_WORLD);
+        else
+            MPI_Recv(received.data(), count, MPI_GENE_RANGE, peer, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE); });
+    report(rank, "balance/bulk", t, moved);
+
+    // Exchange of balance_and_judge: every process sends a block of its
+    // ranges to every process
+    size_t exchanged = count * size;
+    t = best_time(repeat, [&]()
+                  {
+        std::vector<int> send_counts(size), send_displs(size), recv_counts(size);
+        for (int i = 0; i < size; ++i)
+        {
+            send_displs[i] = count * i / size;
+            send_counts[i] = count * (i + 1) / size - send_displs[i];
+        }
+        MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        std::vector<std::vector<gene::GeneRange>> blocks(size);
+        std::vector<MPI_Request> recvs(size, MPI_REQUEST_NULL), sends(size, MPI_REQUEST_NULL);
+        for (int i = 0; i < size; ++i)
+        {
+            blocks[i].resize(recv_counts[i]);
+            MPI_Irecv(blocks[i].data(), recv_counts[i], MPI_GENE_RANGE, i, 0, MPI_COMM_WORLD, &recvs[i]);
+        }
+        for (int i = 0; i < size; ++i)
+            MPI_Isend(ranges.data() + send_displs[i], send_counts[i], MPI_GENE_RANGE, i, 0,
+                      MPI_COMM_WORLD, &sends[i]);
+        for (int n = 0; n < size; ++n)
+        {
+            int i;
+            MPI_Waitany(size, recvs.data(), &i, MPI_STATUS_IGNORE);
+        }
+        MPI_Waitall(size, sends.data(), MPI_STATUSES_IGNORE); });
+    report(rank, "balance/alltoall", t, exchanged);
+
+    // Gathering: all ranges to main process
+    size_t gathered = count * (size - 1);
+    t = best_time(repeat, [&]()
+                  {
+        gene::GeneRange item;
+        if (rank == 0)
+            for (size_t i = 0; i < gathered; ++i)
+                MPI_Recv(&item, 1, MPI_GENE_RANGE, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        else
+            for (size_t i = 0; i < count; ++i)
+                MPI_Send(&ranges[i], 1, MPI_GENE_RANGE, 0, 0, MPI_COMM_WORLD); });
+    report(rank, "gather/per-range", t, gathered);
+    t = best_time(repeat, [&]()
+                  {
+        int n = count;
+        std::vector<int> counts(size), displs(size);
+        MPI_Gather(&n, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (rank == 0)
+        {
+            for (int i = 1; i < size; ++i)
+                displs[i] = displs[i - 1] + counts[i - 1];
+            received.resize(displs[size - 1] + counts[size - 1]);
+        }
+        MPI_Gatherv(ranges.data(), n, MPI_GENE_RANGE, received.data(), counts.data(),
+                    displs.data(), MPI_GENE_RANGE, 0, MPI_COMM_WORLD); });
+    report(rank, "gather/gatherv", t, gathered);
+
+    MPI_Type_free(&MPI_GENE_RANGE);
+    MPI_Finalize();
+    return 0;
+}
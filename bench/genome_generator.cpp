@@ -0,0 +1,133 @@
+#include "synthetic.h"
+#include "../src/lib/Fasta.h"
+#include "../src/lib/InputParser.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+
+/**
+ * @brief Deterministic synthetic genome generator. Same options and seed
+ *        give the same file, so scaling runs can be repeated on any
+ *        machine without shipping large inputs.
+ */
+
+/**
+ * @brief Print usage of program
+ *
+ * @param prog program name
+ */
+void print_usage(const char *prog)
+{
+    std::cout << "Usage: " << prog << " --output OUTPUT_FILE_PATH"
+              << " [--length LENGTH --records RECORDS --skew SKEW --seed SEED --gc GC --cpg CPG"
+              << " --cpg-islands ISLANDS --orfs ORFS --orf-min CODONS --orf-max CODONS"
+              << " --n-runs RUNS --n-length BASES --output-line-width WIDTH]" << std::endl;
+    std::cout << "    Default:" << std::endl
+              << "        LENGTH = 10000000 (bases of all records)" << std::endl
+              << "        RECORDS = 1" << std::endl
+              << "        SKEW = 0 (sigma of log-normal record lengths, 0 for equal records)" << std::endl
+              << "        SEED = 1" << std::endl
+              << "        GC = 0.5" << std::endl
+              << "        CPG = 1 (observed / expected CpG outside of islands)" << std::endl
+              << "        ISLANDS = 0 (CpG islands per Mbp)" << std::endl
+              << "        ORFS = 1 (planted ORFs per kbp), CODONS = 50 to 600" << std::endl
+              << "        RUNS = 0 (N runs per Mbp), BASES = 5000 (mean length of N run)" << std::endl
+              << "        WIDTH = 70" << std::endl;
+}
+
+/**
+ * @brief Read a number option if it exists
+ *
+ * @tparam T
+ * @param input
+ * @param option
+ * @param value
+ */
+template <typename T>
+void read_option(const InputParser &input, const char *option, T &value)
+{
+    if (input.cmdOptionExists(option))
+        std::istringstream(input.getCmdOption(option)) >> value;
+}
+
+/**
+ * @brief Split length into record lengths. Weights are log-normal with
+ *        sigma skew, so a few records are long and most are short.
+ *
+ * @param length
+ * @param records
+ * @param skew
+ * @param rng
+ * @return std::vector<size_t>
+ */
+std::vector<size_t> record_lengths(size_t length, size_t records, double skew, std::mt19937_64 &rng)
+{
+    std::lognormal_distribution<double> weight(0, skew);
+    std::vector<double> weights(records);
+    double total = 0;
+    for (auto &w : weights)
+        total += w = skew > 0 ? weight(rng) : 1;
+    // Record i ends at the rounded prefix sum of weights, so lengths add up to length
+    std::vector<size_t> result(records);
+    double sum = 0;
+    size_t end = 0;
+    for (size_t i = 0; i < records; ++i)
+    {
+        sum += weights[i];
+        size_t next = i + 1 == records ? length : size_t(std::llround(length * sum / total));
+        result[i] = next - end;
+        end = next;
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    InputParser input = InputParser(argc, argv);
+    if (input.cmdOptionExists("-h") || input.cmdOptionExists("--help") ||
+        !input.cmdOptionExists("--output"))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string output_file = input.getCmdOption("--output");
+    size_t length = 10000000, records = 1, line_width = 70;
+    uint64_t seed = 1;
+    double skew = 0;
+    gene::bench::SyntheticOptions options;
+    read_option(input, "--length", length);
+    read_option(input, "--records", records);
+    read_option(input, "--skew", skew);
+    read_option(input, "--seed", seed);
+    read_option(input, "--gc", options.gc);
+    read_option(input, "--cpg", options.cpg);
+    read_option(input, "--cpg-islands", options.cpgIslands);
+    read_option(input, "--orfs", options.orfs);
+    read_option(input, "--orf-min", options.minCodons);
+    read_option(input, "--orf-max", options.maxCodons);
+    read_option(input, "--n-runs", options.nRuns);
+    read_option(input, "--n-length", options.nLength);
+    read_option(input, "--output-line-width", line_width);
+    if (records == 0)
+        records = 1;
+
+    Fasta out(output_file.c_str(), std::ios::out);
+    std::mt19937_64 rng(seed);
+    auto lengths = record_lengths(length, records, skew, rng);
+    for (size_t i = 0; i < records; ++i)
+    {
+        // Every record has its own seed, so it does not depend on the others
+        std::ostringstream label;
+        label << "synthetic_" << i + 1 << " seed=" << seed << " length=" << lengths[i];
+        Sequence seq(label.str(), gene::bench::synthesize(lengths[i], options, seed * 1000003 + i));
+        if (!out.write(seq, line_width))
+        {
+            std::cerr << "Failed to write " << output_file << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include "bench.h"
+#include "synthetic.h"
+#include "../src/lib/orf_finder.h"
+#include "../src/lib/JudgeContext.h"
+#include "../src/lib/range_collect.h"
+#include "../src/lib/Fasta.h"
+#include "../src/lib/FastaWriter.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <algorithm>
+
+/**
+ * @brief Microbenchmarks of core kernels of gene finder: ORF scanning,
+ *        judging, judge cost batching, fasta reading and writing. They run
+ *        on synthetic sequences of controlled GC content and ORF density,
+ *        and on fasta files in data directory.
+ *
+ *        Usage: microbench [--data=DIR] [--benchmark_* options of bench.h]
+ */
+
+#ifndef GENE_FINDER_DATA_DIR
+#define GENE_FINDER_DATA_DIR "data"
+#endif
+
+// Length of synthetic sequences
+const size_t LENGTH = 1 << 20;
+
+/**
+ * @brief Synthetic sequence of a benchmark
+ */
+struct Synthetic
+{
+    std::string name;
+    std::unique_ptr<Sequence> seq;
+};
+
+/**
+ * @brief Find ORFs of all six frames
+ *
+ * @param seq
+ * @param mode
+ * @return std::vector<gene::GeneRange>
+ */
+std::vector<gene::GeneRange> all_orfs(const Sequence &seq, gene::ScanMode mode)
+{
+    std::vector<gene::GeneRange> result;
+    for (int frame = -3; frame <= 3; ++frame)
+        if (frame != 0)
+        {
+            auto orfs = gene::getORFS(seq, frame, 0, seq.getSequence().length(), mode);
+            result.insert(result.end(), orfs.begin(), orfs.end());
+        }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_dir = GENE_FINDER_DATA_DIR;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]).rfind("--data=", 0) == 0)
+            data_dir = argv[i] + 7;
+    auto temp = (std::filesystem::temp_directory_path() / "gene_finder_microbench.fa").string();
+    gene::bench::Runner runner;
+
+    // Sequences of GC content and planted ORFs per kb
+    const std::pair<int, int> configs[] = {{30, 1}, {50, 1}, {70, 1}, {50, 0}, {50, 5}};
+    std::vector<Synthetic> sequences;
+    for (auto &config : configs)
+    {
+        auto name = "gc:" + std::to_string(config.first) + "/orfs:" + std::to_string(config.second);
+        auto data = gene::bench::synthesize(LENGTH, config.first / 100.0, config.second, 42);
+        sequences.push_back({name, std::unique_ptr<Sequence>(new Sequence(name, std::move(data)))});
+    }
+
+    // ORF scanning engines, all six frames
+    const std::pair<const char *, gene::ScanMode> modes[] = {
+        {"forward", gene::ScanMode::Forward},
+        {"linear", gene::ScanMode::Linear},
+        {"simd", gene::ScanMode::Simd}};
+    for (auto &mode : modes)
+        for (auto &s : sequences)
+        {
+            auto seq = s.seq.get();
+            auto scan_mode = mode.second;
+            runner.add(std::string("getORFS/") + mode.first + "/" + s.name, [seq, scan_mode](gene::bench::State &state)
+                       {
+                size_t orfs = 0;
+                while (state.keepRunning())
+                    orfs += all_orfs(*seq, scan_mode).size();
+                state.setBytesProcessed(double(LENGTH) * state.getIterations());
+                state.setItemsProcessed(orfs); });
+        }
+    auto packed = std::make_shared<Sequence>("packed", sequences[1].seq->getSequence());
+    packed->pack();
+    runner.add("getORFS/linear/packed/" + sequences[1].name, [packed](gene::bench::State &state)
+               {
+        size_t orfs = 0;
+        while (state.keepRunning())
+            orfs += all_orfs(*packed, gene::ScanMode::Linear).size();
+        state.setBytesProcessed(double(LENGTH) * state.getIterations());
+        state.setItemsProcessed(orfs); });
+
+    // Judge, every ORF of sequence with one judge context
+    for (auto &s : sequences)
+    {
+        auto seq = s.seq.get();
+        auto orfs = std::make_shared<std::vector<gene::GeneRange>>(all_orfs(*seq, gene::ScanMode::Linear));
+        runner.add("judge/" + s.name, [seq, orfs](gene::bench::State &state)
+                   {
+            gene::JudgeContext judge(*seq);
+            std::vector<gene::GeneRange> judged(orfs->size());
+            while (state.keepRunning())
+                judge.judge(orfs->data(), orfs->size(), judged.data());
+            state.setItemsProcessed(double(orfs->size()) * state.getIterations()); });
+    }
+    auto seq = sequences[1].seq.get();
+    runner.add("judge/prepare/" + sequences[1].name, [seq](gene::bench::State &state)
+               {
+        while (state.keepRunning())
+            gene::JudgeContext judge(*seq);
+        state.setBytesProcessed(double(LENGTH) * state.getIterations()); });
+
+    // Helpers of balancing ORFs by judge cost, on the sequence of most ORFs
+    auto dense = sequences[4].seq.get();
+    auto orfs = std::make_shared<std::vector<gene::GeneRange>>(all_orfs(*dense, gene::ScanMode::Linear));
+    auto judged = std::make_shared<std::vector<gene::GeneRange>>(orfs->size());
+    {
+        gene::JudgeContext judge(*dense);
+        judge.judge(orfs->data(), orfs->size(), judged->data());
+    }
+    runner.add("balance/cost/" + sequences[4].name, [orfs, dense](gene::bench::State &state)
+               {
+        gene::JudgeContext judge(*dense);
+        std::vector<double> costs(orfs->size());
+        while (state.keepRunning())
+            judge.cost(orfs->data(), orfs->size(), costs.data());
+        state.setItemsProcessed(double(orfs->size()) * state.getIterations()); });
+    runner.add("balance/splitBatches/" + sequences[4].name, [orfs, dense](gene::bench::State &state)
+               {
+        gene::JudgeContext judge(*dense);
+        while (state.keepRunning())
+            judge.splitBatches(orfs->data(), orfs->size(), orfs->size() / 1024 + 1);
+        state.setItemsProcessed(double(orfs->size()) * state.getIterations()); });
+    runner.add("balance/compactRanges/" + sequences[4].name, [judged](gene::bench::State &state)
+               {
+        while (state.keepRunning())
+            gene::compactRanges(*judged);
+        state.setItemsProcessed(double(judged->size()) * state.getIterations()); });
+
+    // Reading fasta files of data directory, and a synthetic file of many records
+    std::vector<std::string> files;
+    std::error_code error;
+    for (auto &entry : std::filesystem::directory_iterator(data_dir, error))
+        if (entry.path().extension() == ".fasta")
+            files.push_back(entry.path().string());
+    std::sort(files.begin(), files.end());
+    auto records = (std::filesystem::temp_directory_path() / "gene_finder_microbench_records.fa").string();
+    {
+        Fasta out(records.c_str(), std::ios::out);
+        for (int i = 0; i < 64; ++i)
+            out.write(Sequence("record " + std::to_string(i),
+                               gene::bench::synthesize(LENGTH / 16, 0.5, 1, i)), 70);
+    }
+    files.push_back(records);
+    for (auto &file : files)
+    {
+        auto bytes = std::filesystem::file_size(file, error);
+        auto name = file == records ? std::string("synthetic") : std::filesystem::path(file).filename().string();
+        runner.add("fasta/getNextSequence/" + name, [file, bytes](gene::bench::State &state)
+                   {
+            while (state.keepRunning())
+            {
+                Fasta in(file.c_str(), std::ios::in);
+                while (in.getNextSequence())
+                    ;
+            }
+            state.setBytesProcessed(double(bytes) * state.getIterations()); });
+    }
+
+    // Writing a sequence, and genes of judged ORFs
+    runner.add("fasta/write/" + sequences[1].name, [seq, temp](gene::bench::State &state)
+               {
+        while (state.keepRunning())
+        {
+            Fasta out(temp.c_str(), std::ios::out);
+            out.write(*seq, 70);
+        }
+        state.setBytesProcessed(double(LENGTH) * state.getIterations()); });
+    auto genes = std::make_shared<std::vector<gene::GeneRange>>(gene::compactRanges(*judged));
+    runner.add("fasta/writeRecords/" + sequences[4].name, [genes, temp, dense](gene::bench::State &state)
+               {
+        while (state.keepRunning())
+        {
+            Fasta out(temp.c_str(), std::ios::out);
+            writeRecords(out, genes->size(), [&](size_t i, FastaBuffer &buffer)
+                         {
+                auto &range = (*genes)[i];
+                buffer.appendLabel("%s | gene | LOC=[%d,%d]", dense->getLabel().c_str(), range.start, range.end);
+                buffer.appendBases(dense->getSequence().data() + range.abs_start(), range.length(), 70); });
+        }
+        state.setItemsProcessed(double(genes->size()) * state.getIterations()); });
+
+    int result = runner.run(argc, argv);
+    std::filesystem::remove(temp, error);
+    std::filesystem::remove(records, error);
+    return result;
+}
@@ -0,0 +1,158 @@
+#pragma once
+#ifndef _SYNTHETIC_H
+#define _SYNTHETIC_H
+#include <string>
+#include <random>
+#include <algorithm>
+#include <stdint.h>
+
+namespace gene
+{
+    namespace bench
+    {
+        /**
+         * @brief Options of a synthetic sequence. Densities are per 1000
+         *        bases for ORFs, and per 1000000 bases for islands and runs.
+         */
+        struct SyntheticOptions
+        {
+            // GC content, in [0, 1]
+            double gc = 0.5;
+            // Probability to keep a CpG outside of CpG islands, 1 keeps
+            // CpG as random, 0.25 gives observed / expected CpG of about
+            // 0.35 as in a vertebrate genome
+            double cpg = 1;
+            // CpG islands of islandLength bases, GC content 0.65 and no
+            // CpG depletion
+            double cpgIslands = 0;
+            size_t islandLength = 1000;
+            // Planted ORFs, length in codons is uniform in [minCodons, maxCodons]
+            double orfs = 1;
+            size_t minCodons = 50;
+            size_t maxCodons = 600;
+            // Runs of N, length is exponential with mean nLength
+            double nRuns = 0;
+            size_t nLength = 5000;
+        };
+
+        /**
+         * @brief Fill [begin, end) of data with random bases. Bases are G or
+         *        C with probability gc, and a G after C is turned into C with
+         *        probability 1 - cpg, so GC content is kept.
+         *
+         * @param data
+         * @param begin
+         * @param end
+         * @param gc
+         * @param cpg
+         * @param rng
+         */
+        inline void fillBases(std::string &data, size_t begin, size_t end, double gc, double cpg,
+                              std::mt19937_64 &rng)
+        {
+            std::uniform_real_distribution<double> unit(0, 1);
+            for (size_t i = begin; i < end; ++i)
+            {
+                bool strong = unit(rng) < gc;
+                bool second = unit(rng) < 0.5;
+                char c = strong ? (second ? 'G' : 'C') : (second ? 'A' : 'T');
+                if (c == 'G' && i > 0 && data[i - 1] == 'C' && cpg < 1 && unit(rng) >= cpg)
+                    c = 'C';
+                data[i] = c;
+            }
+        }
+
+        /**
+         * @brief Round a mean count up or down at random, so short records
+         *        get features at the same density as long records. An
+         *        integer mean takes no random number.
+         *
+         * @param mean
+         * @param rng
+         * @return size_t
+         */
+        inline size_t randomCount(double mean, std::mt19937_64 &rng)
+        {
+            size_t count = size_t(mean);
+            double fraction = mean - count;
+            if (fraction > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < fraction)
+                ++count;
+            return count;
+        }
+
+        /**
+         * @brief Make a deterministic random DNA sequence of options. ORFs
+         *        are planted at random positions: ATG, codons without stop
+         *        codon, and a stop codon, so ORF density is controlled on
+         *        top of the ORFs that occur by chance. N runs are placed
+         *        last, and may cut planted ORFs.
+         *
+         * @param length
+         * @param options
+         * @param seed
+         * @return std::string
+         */
+        inline std::string synthesize(size_t length, const SyntheticOptions &options, uint64_t seed)
+        {
+            std::mt19937_64 rng(seed);
+            std::uniform_real_distribution<double> unit(0, 1);
+            std::string data(length, 'A');
+            fillBases(data, 0, length, options.gc, options.cpg, rng);
+            // CpG islands
+            size_t islands = randomCount(length / 1e6 * options.cpgIslands, rng);
+            for (size_t k = 0; k < islands && options.islandLength < length; ++k)
+            {
+                size_t at = std::uniform_int_distribution<size_t>(0, length - options.islandLength)(rng);
+                fillBases(data, at, at + options.islandLength, 0.65, 1, rng);
+            }
+            // ORFs
+            const char *stops[3] = {"TAA", "TAG", "TGA"};
+            std::uniform_int_distribution<size_t> codons(options.minCodons, std::max(options.minCodons, options.maxCodons));
+            size_t count = randomCount(length / 1000.0 * options.orfs, rng);
+            for (size_t k = 0; k < count; ++k)
+            {
+                size_t n = codons(rng);
+                size_t orf = (n + 2) * 3;
+                if (orf >= length)
+                    continue;
+                size_t at = std::uniform_int_distribution<size_t>(0, length - orf)(rng);
+                data.replace(at, 3, "ATG");
+                // Body codons are rerolled until they are not a stop codon
+                for (size_t i = at + 3; i < at + orf - 3; i += 3)
+                    while ((data[i] == 'T' && data[i + 1] == 'A' && (data[i + 2] == 'A' || data[i + 2] == 'G')) ||
+                           (data[i] == 'T' && data[i + 1] == 'G' && data[i + 2] == 'A'))
+                        data[i + 2] = "ACGT"[rng() & 3];
+                data.replace(at + orf - 3, 3, stops[rng() % 3]);
+            }
+            // N runs
+            size_t runs = randomCount(length / 1e6 * options.nRuns, rng);
+            std::exponential_distribution<double> run_length(1.0 / std::max<size_t>(options.nLength, 1));
+            for (size_t k = 0; k < runs; ++k)
+            {
+                size_t n = std::min(length, size_t(run_length(rng)) + 1);
+                size_t at = std::uniform_int_distribution<size_t>(0, length - n)(rng);
+                std::fill(data.begin() + at, data.begin() + at + n, 'N');
+            }
+            return data;
+        }
+
+        /**
+         * @brief Make a deterministic random DNA sequence of GC content and
+         *        planted ORF density
+         *
+         * @param length
+         * @param gc            GC content, in [0, 1]
+         * @param orfs_per_kb   Planted ORFs per 1000 bases
+         * @param seed
+         * @return std::string
+         */
+        inline std::string synthesize(size_t length, double gc, double orfs_per_kb, uint64_t seed)
+        {
+            SyntheticOptions options;
+            options.gc = gc;
+            options.orfs = orfs_per_kb;
+            return synthesize(length, options, seed);
+        }
+    }
+}
+#endif
@@ -0,0 +1,65 @@
+#!/bin/bash
+# Check that gene_finder_mpi finds the same genes with every process count.
+# Runs in MODE (--fai by default) are compared with one process reading
+# whole records, both with ARGS (--longest-orf by default). Input is made
+# by genome_generator, records of skewed length are split at many positions.
+#
+# Usage: ./check_ranks.sh [--bin DIR] [--input FILE] [--ranks "1 2 3 4 7"]
+#                         [--mode "MODE"] [--args "ARGS"] [--mpi-args "ARGS"] [--work DIR]
+
+BIN=$(cd "$(dirname "$0")" && pwd)
+INPUT=""
+RANKS="1 2 3 4 7"
+MODE="--fai"
+ARGS="--longest-orf"
+MPI_ARGS="--oversubscribe"
+WORK=""
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --bin) BIN="$2"; shift ;;
+        --input) INPUT="$2"; shift ;;
+        --ranks) RANKS="$2"; shift ;;
+        --mode) MODE="$2"; shift ;;
+        --args) ARGS="$2"; shift ;;
+        --mpi-args) MPI_ARGS="$2"; shift ;;
+        --work) WORK="$2"; shift ;;
+        -h|--help) sed -n '2,8p' "$0" | sed 's/^# \{0,1\}//'; exit 0 ;;
+        *) echo "Unknown option $1" >&2; exit 1 ;;
+    esac
+    shift
+done
+if [ "$(id -u)" -eq 0 ]; then
+    MPI_ARGS="$MPI_ARGS --allow-run-as-root"
+fi
+if [ -z "$WORK" ]; then
+    WORK=$(mktemp -d)
+    trap 'rm -rf "$WORK"' EXIT
+fi
+export LD_LIBRARY_PATH=$BIN:$LD_LIBRARY_PATH
+if [ -z "$INPUT" ]; then
+    INPUT="$WORK/synthetic.fasta"
+    "$BIN/genome_generator" --output "$INPUT" --length 3000000 --records 200 --skew 1 --orfs 3 --seed 7 || exit 1
+fi
+
+# Genes of an output, one line per gene, sorted
+genes() {
+    awk '/^>/ { if (g != "") print g; g = $0 "\t"; next } { g = g $0 } END { if (g != "") print g }' "$1" | sort
+}
+
+mpirun $MPI_ARGS -np 1 "$BIN/gene_finder_mpi" --input "$INPUT" --output "$WORK/reference.fasta" \
+    $ARGS > /dev/null || exit 1
+genes "$WORK/reference.fasta" > "$WORK/reference.txt"
+failed=0
+for n in $RANKS; do
+    mpirun $MPI_ARGS -np "$n" "$BIN/gene_finder_mpi" --input "$INPUT" --output "$WORK/out.fasta" \
+        $MODE $ARGS > /dev/null || exit 1
+    genes "$WORK/out.fasta" > "$WORK/out.txt"
+    if cmp -s "$WORK/reference.txt" "$WORK/out.txt"; then
+        echo "$n processes: $(wc -l < "$WORK/out.txt") genes, same"
+    else
+        echo "$n processes: genes differ"
+        diff "$WORK/reference.txt" "$WORK/out.txt" | cut -c 1-120 | head -n 10
+        failed=1
+    fi
+done
+exit $failed
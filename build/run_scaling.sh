@@ -0,0 +1,139 @@
+#!/bin/bash
+# Strong and weak scaling of gene_finder over threads and gene_finder_mpi
+# over processes on one machine. Inputs are made by genome_generator, so
+# runs are repeatable without a cluster or a large input file.
+#
+# Usage: ./run_scaling.sh [--bin DIR] [--input FILE] [--length BASES] [--records N]
+#                         [--gen-args "ARGS"] [--threads "1 2 4"] [--ranks "1 2 4"]
+#                         [--mpi-threads N] [--mpi-args "ARGS"] [--finder-args "ARGS"]
+#                         [--repeat N] [--weak] [--work DIR]
+#
+# Strong scaling runs one input, of LENGTH bases or FILE, with every thread
+# and process count. Weak scaling makes an input of LENGTH bases per thread
+# or process. Time is the best of REPEAT runs, as printed by --time.
+
+BIN=$(cd "$(dirname "$0")" && pwd)
+INPUT=""
+LENGTH=20000000
+RECORDS=1
+GEN_ARGS=""
+THREADS="1 2 4"
+RANKS="1 2 4"
+MPI_THREADS=1
+MPI_ARGS="--oversubscribe"
+FINDER_ARGS=""
+REPEAT=3
+WEAK=0
+WORK=""
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --bin) BIN="$2"; shift ;;
+        --input) INPUT="$2"; shift ;;
+        --length) LENGTH="$2"; shift ;;
+        --records) RECORDS="$2"; shift ;;
+        --gen-args) GEN_ARGS="$2"; shift ;;
+        --threads) THREADS="$2"; shift ;;
+        --ranks) RANKS="$2"; shift ;;
+        --mpi-threads) MPI_THREADS="$2"; shift ;;
+        --mpi-args) MPI_ARGS="$2"; shift ;;
+        --finder-args) FINDER_ARGS="$2"; shift ;;
+        --repeat) REPEAT="$2"; shift ;;
+        --weak) WEAK=1 ;;
+        --work) WORK="$2"; shift ;;
+        -h|--help) sed -n '2,13p' "$0" | sed 's/^# \{0,1\}//'; exit 0 ;;
+        *) echo "Unknown option $1" >&2; exit 1 ;;
+    esac
+    shift
+done
+if [ "$(id -u)" -eq 0 ]; then
+    MPI_ARGS="$MPI_ARGS --allow-run-as-root"
+fi
+if [ -z "$WORK" ]; then
+    WORK=$(mktemp -d)
+    trap 'rm -rf "$WORK"' EXIT
+fi
+export LD_LIBRARY_PATH=$BIN:$LD_LIBRARY_PATH
+
+# Input of a run: FILE, or a generated input of length bases
+input_of() {
+    if [ -n "$INPUT" ]; then
+        echo "$INPUT"
+        return
+    fi
+    local file="$WORK/synthetic_$1.fasta"
+    if [ ! -f "$file" ]; then
+        "$BIN/genome_generator" --output "$file" --length "$1" --records "$RECORDS" $GEN_ARGS || exit 1
+    fi
+    echo "$file"
+}
+
+# Best time of REPEAT runs of a command, output goes to $WORK/out.fasta
+best_time() {
+    local best=""
+    for ((i = 0; i < REPEAT; ++i)); do
+        local t
+        t=$("$@" --output "$WORK/out.fasta" --time $FINDER_ARGS 2>/dev/null | tail -n 1)
+        if [ -z "$t" ]; then
+            echo "Run failed: $*" >&2
+            exit 1
+        fi
+        best=$(awk -v a="$best" -v b="$t" 'BEGIN { print (a == "" || b < a) ? b : a }')
+    done
+    echo "$best"
+}
+
+# Print a scaling table of a program, $1 is the title, $2 the worker
+# label, $3 the worker counts, and $4 a function that runs n workers
+scaling() {
+    local base="" base_n=""
+    echo
+    echo "$1"
+    printf "%10s %12s %10s %12s %10s\n" "$2" "time(s)" "speedup" "efficiency" "genes"
+    for n in $3; do
+        local length=$LENGTH
+        if [ $WEAK -eq 1 ]; then
+            length=$((LENGTH * n))
+        fi
+        local t count
+        t=$($4 "$n" "$(input_of "$length")") || exit 1
+        count=$(grep -c '>' "$WORK/out.fasta")
+        if [ -z "$base" ]; then
+            base=$t
+            base_n=$n
+        fi
+        # Weak scaling: efficiency is T1 / Tn, speedup is n times it
+        awk -v n="$n" -v b="$base" -v bn="$base_n" -v t="$t" -v g="$count" -v weak=$WEAK 'BEGIN {
+            s = weak ? n / bn * b / t : b / t
+            printf "%10d %12.3f %10.2f %11.1f%% %10d\n", n, t, s, s / (n / bn) * 100, g }'
+    done
+}
+
+run_threads() {
+    OMP_NUM_THREADS=$1 best_time "$BIN/gene_finder" --input "$2"
+}
+
+run_ranks() {
+    OMP_NUM_THREADS=$MPI_THREADS best_time mpirun $MPI_ARGS -np "$1" "$BIN/gene_finder_mpi" --input "$2"
+}
+
+MODE="Strong scaling"
+PER=""
+if [ $WEAK -eq 1 ]; then
+    MODE="Weak scaling"
+    PER=" per worker"
+fi
+if [ -n "$INPUT" ] && [ $WEAK -eq 1 ]; then
+    echo "Weak scaling needs generated inputs, --input can not be used" >&2
+    exit 1
+fi
+if [ -n "$INPUT" ]; then
+    echo "$MODE, input $INPUT, best of $REPEAT runs"
+else
+    echo "$MODE, synthetic input of $LENGTH bases$PER in $RECORDS records, best of $REPEAT runs"
+fi
+if [ -n "$THREADS" ]; then
+    scaling "gene_finder, OMP_NUM_THREADS" "threads" "$THREADS" run_threads
+fi
+if [ -n "$RANKS" ] && command -v mpirun > /dev/null; then
+    scaling "gene_finder_mpi, mpirun -np N, OMP_NUM_THREADS=$MPI_THREADS" "processes" "$RANKS" run_ranks
+fi
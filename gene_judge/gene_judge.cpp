@@ -1,6 +1,7 @@
 #include "./lib/gene_judge.h"
-#include <omp.h>
+#include "./lib/CpGIndex.h"
 #include <string_view>
+#include <algorithm>
 
 /**
  * Judge ORF is a gene or not, this is a simple demo that following this
@@ -10,10 +11,23 @@
  *  - ORF must occur in a CpG
  *  - CpG should appear in first third of the sequence
  * 
+ * C, G and CpG counts of every 200 bp window are taken from a CpGIndex,
+ * which is built once per sequence. The batch API keeps the index in the
+ * context of sequence.
+ * 
  * User can modifie this file, then using ``make gene_judge`` command
  * that process gene finding algorithm by they defined.
  */
-gene::GeneRange isGene(const gene::GeneRange &range, const Sequence &seq)
+/**
+ * @brief Judge a range with a CpG index of sequence
+ * 
+ * @param range 
+ * @param seq 
+ * @param index 
+ * @return true     Range is a gene.
+ * @return false    Range is not a gene.
+ */
+static bool isCpGGene(const gene::GeneRange &range, const Sequence &seq, const CpGIndex &index)
 {
     // Init varible
     auto start = range.abs_start();
@@ -24,44 +38,94 @@ gene::GeneRange isGene(const gene::GeneRange &range, const Sequence &seq)
 
     int n = 200; double t_ratio = 0.6; double t_gc = 0.5;
 
-    gene::GeneRange result{INVALID_RANGE_LOC,INVALID_RANGE_LOC,INVALID_FRAME};
-    // Init string_view for faster access
-    std::string_view seq_view(
-        seq.getSequence().c_str(),
-        seq.getSequence().length());
-    auto l = seq_view.length();
+    auto l = seq.getSequence().length();
     // Check if range is invalid
     if (l < n || start >= l - n || end > l - n)
-        return result;
+        return false;
     // Check if it has at least 96 bp
     if (range.length() < 96)
-        return result;
+        return false;
     // Searching Cpg island
-    #pragma omp parallel for
-    for (int64_t i = start; i < end; ++i)
+    for (auto i = start; i < end; ++i)
     {
         // Getting nC, nG, nCpG for current window
-        size_t nC = 0, nG = 0, nCpG = 0;
-        for (int64_t j = i; j < i + 200; ++j)
-        {
-            if (seq_view[j] == 'C')
-            {
-                ++nC;
-                if (j + 1 < l && seq_view[j + 1] == 'G')
-                    ++nCpG;
-            }
-            else if (seq_view[j] == 'G')
-                ++nG;
-        }
+        auto counts = index.count(i, n);
         // Get Obs/Exp and GC content
-        double oe_ratio = nCpG;
-        oe_ratio = oe_ratio / (nC * nG) * n;
-        double gc_content = nC + nG;
+        double oe_ratio = counts.cpg;
+        oe_ratio = oe_ratio / (counts.c * counts.g) * n;
+        double gc_content = counts.c + counts.g;
         gc_content /= n;
-        // Check and set result, not return because OpenMP
+        // Check result
         if (oe_ratio > t_ratio && gc_content > t_gc)
-            result = range;
+            return true;
     }
+    return false;
+}
 
+gene::GeneRange isGene(const gene::GeneRange &range, const Sequence &seq)
+{
+    gene::GeneRange result{INVALID_RANGE_LOC,INVALID_RANGE_LOC,INVALID_FRAME};
+    // Check length first, so short ORF does not build index
+    if (range.length() < 96)
+        return result;
+    if (isCpGGene(range, seq, *CpGIndex::get(seq)))
+        result = range;
     return result;
+}
+
+/**
+ * @brief Batch context, CpG index of a sequence
+ */
+struct CpGContext
+{
+    const Sequence *seq;
+    std::shared_ptr<const CpGIndex> index;
+};
+
+int isGeneBatchVersion()
+{
+    return GENE_JUDGE_BATCH_API_VERSION;
+}
+
+void *isGenePrepare(const Sequence *seq)
+{
+    return new CpGContext{seq, std::make_shared<const CpGIndex>(*seq)};
+}
+
+void isGeneJudge(void *context, const gene::GeneRange *ranges, size_t n, uint8_t *out_mask)
+{
+    auto ctx = (const CpGContext *)context;
+    for (size_t i = 0; i < n; ++i)
+        out_mask[i] = isCpGGene(ranges[i], *ctx->seq, *ctx->index);
+}
+
+void isGeneRelease(void *context)
+{
+    delete (CpGContext *)context;
+}
+
+void isGeneCost(void *context, const gene::GeneRange *ranges, size_t n, double *out_cost)
+{
+    auto ctx = (const CpGContext *)context;
+    auto l = ctx->index->size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        // Short ORF is rejected at once
+        auto length = ranges[i].length();
+        if (length < 96)
+        {
+            out_cost[i] = 1;
+            continue;
+        }
+        // Windows are tested until a CpG island is found, it is found
+        // early if the searched region is a CpG island as a whole
+        auto windows = length / 3;
+        auto start = std::min<size_t>(ranges[i].abs_start(), l);
+        auto n_bases = std::min<size_t>(windows + 200, l - start);
+        auto counts = ctx->index->count(start, n_bases);
+        bool island = n_bases != 0 && counts.c * counts.g != 0 &&
+                      (double)counts.cpg / (counts.c * counts.g) * n_bases > 0.6 &&
+                      (double)(counts.c + counts.g) / n_bases > 0.5;
+        out_cost[i] = island ? 2 : 1 + windows;
+    }
 }
\ No newline at end of file
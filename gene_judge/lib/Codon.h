@@ -0,0 +1 @@
+../../src/lib/Codon.h
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "./CpGIndex.h"
+#include "./PackedSequence.h"
+#include <mutex>
+#include <deque>
+#include <utility>
+
+// Number of sequences kept in cache
+const size_t CACHE_SIZE = 4;
+
+CpGIndex::CpGIndex(const Sequence &seq)
+{
+    const auto &data = seq.getSequence();
+    auto packed = seq.getPacked();
+    this->length = data.length();
+    this->blocks.assign(this->length / 64 + 1, Block{0, 0, 0, 0, 0, 0});
+    // Bitmasks of C and G
+    for (size_t j = 0; j < this->length; ++j)
+    {
+        bool isC, isG;
+        if (packed != nullptr)
+        {
+            // Exception bases are stored as A
+            auto code = packed->code(j);
+            isC = code == gene::codon::BASE_C;
+            isG = code == gene::codon::BASE_G;
+        }
+        else
+        {
+            isC = data[j] == 'C';
+            isG = data[j] == 'G';
+        }
+        this->blocks[j >> 6].c |= (uint64_t)isC << (j & 63);
+        this->blocks[j >> 6].g |= (uint64_t)isG << (j & 63);
+    }
+    // Bitmask of C followed by G, and counts before every block
+    uint64_t rankC = 0, rankG = 0, rankCpG = 0;
+    for (size_t b = 0; b < this->blocks.size(); ++b)
+    {
+        auto &block = this->blocks[b];
+        uint64_t nextG = block.g >> 1;
+        if (b + 1 < this->blocks.size())
+            nextG |= (this->blocks[b + 1].g & 1) << 63;
+        block.cpg = block.c & nextG;
+        block.rankC = rankC;
+        block.rankG = rankG;
+        block.rankCpG = rankCpG;
+        rankC += __builtin_popcountll(block.c);
+        rankG += __builtin_popcountll(block.g);
+        rankCpG += __builtin_popcountll(block.cpg);
+    }
+}
+
+size_t CpGIndex::size() const
+{
+    return this->length;
+}
+
+std::shared_ptr<const CpGIndex> CpGIndex::get(const Sequence &seq)
+{
+    static std::mutex lock;
+    static std::deque<std::pair<uint64_t, std::shared_ptr<const CpGIndex>>> cache;
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto &item : cache)
+        if (item.first == seq.getId())
+            return item.second;
+    // Build index while holding the lock, so other threads of same
+    // sequence wait for it instead of building it again
+    auto index = std::make_shared<const CpGIndex>(seq);
+    cache.emplace_front(seq.getId(), index);
+    if (cache.size() > CACHE_SIZE)
+        cache.pop_back();
+    return index;
+}
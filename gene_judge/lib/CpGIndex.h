@@ -0,0 +1,91 @@
+#ifndef _CPG_INDEX_H
+#define _CPG_INDEX_H
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include "./Sequence.h"
+
+/**
+ * @brief Prefix counts of C, G and CpG of a sequence. Bases are kept as
+ *        bitmasks of 64 positions with the count before every block, so
+ *        count of any window is two lookups and a popcount (O(1)).
+ *        Index is built once per sequence.
+ */
+class CpGIndex
+{
+public:
+    /**
+     * @brief Counts of a window
+     */
+    struct Counts
+    {
+        size_t c;
+        size_t g;
+        size_t cpg;
+    };
+
+private:
+    struct Block
+    {
+        // Bit k is set if position k of block is C, G, or C followed by G
+        uint64_t c, g, cpg;
+        // Count before the block
+        uint64_t rankC, rankG, rankCpG;
+    };
+    std::vector<Block> blocks;
+    size_t length;
+
+public:
+    /**
+     * @brief Build index of a sequence, from packed sequence if it is
+     *        available.
+     *
+     * @param seq
+     */
+    explicit CpGIndex(const Sequence &seq);
+    /**
+     * @brief Get counts of C, G and CpG (C at position in window, followed
+     *        by G) in window [pos, pos + n)
+     *
+     * @param pos
+     * @param n
+     * @return Counts
+     */
+    inline Counts count(size_t pos, size_t n) const
+    {
+        Counts begin = this->prefix(pos), end = this->prefix(pos + n);
+        return {end.c - begin.c, end.g - begin.g, end.cpg - begin.cpg};
+    }
+    /**
+     * @brief Get counts of C, G and CpG before pos
+     *
+     * @param pos
+     * @return Counts
+     */
+    inline Counts prefix(size_t pos) const
+    {
+        const Block &b = this->blocks[pos >> 6];
+        uint64_t mask = (1ULL << (pos & 63)) - 1;
+        return {(size_t)(b.rankC + __builtin_popcountll(b.c & mask)),
+                (size_t)(b.rankG + __builtin_popcountll(b.g & mask)),
+                (size_t)(b.rankCpG + __builtin_popcountll(b.cpg & mask))};
+    }
+    /**
+     * @brief Get length of indexed sequence
+     *
+     * @return size_t
+     */
+    size_t size() const;
+    /**
+     * @brief Get index of a sequence from cache, the index is built if it
+     *        is not in the cache. Cache is keyed by Sequence::getId(), and
+     *        keeps a few recent sequences. Thread safe.
+     *
+     * @param seq
+     * @return std::shared_ptr<const CpGIndex>
+     */
+    static std::shared_ptr<const CpGIndex> get(const Sequence &seq);
+};
+
+#endif //_CPG_INDEX_H
@@ -0,0 +1 @@
+../../src/lib/PackedSequence.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/lib/PackedSequence.h
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "./Sequence.h"
 #include "./GeneRange.h"
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef _MSC_VER // For MSVC
     #define CROSS_PLATFORM_HIDDEN_API
@@ -26,4 +28,64 @@
  */
 CROSS_PLATFORM_API gene::GeneRange isGene(const gene::GeneRange & range, const Sequence & seq);
 
+/**
+ * Optional batch API. A judge library can export these functions to
+ * share per-sequence precomputation (index, cache) across all ORFs of
+ * all six frames of a sequence. The driver looks them up at runtime, and
+ * uses isGene for each ORF if they are missing or the version does not
+ * match GENE_JUDGE_BATCH_API_VERSION.
+ */
+#define GENE_JUDGE_BATCH_API_VERSION 1
+
+extern "C"
+{
+    /**
+     * @brief Get version of batch API implemented by the library.
+     * 
+     * @return int  GENE_JUDGE_BATCH_API_VERSION
+     */
+    CROSS_PLATFORM_API int isGeneBatchVersion();
+
+    /**
+     * @brief Prepare a context of a sequence. The sequence stays alive
+     *        until the context is released.
+     * 
+     * @param seq 
+     * @return void*    Context of sequence
+     */
+    CROSS_PLATFORM_API void *isGenePrepare(const Sequence *seq);
+
+    /**
+     * @brief Judge n ranges of the sequence of context. out_mask[i] is set
+     *        to 1 if ranges[i] is a gene, otherwise 0. It can be called
+     *        from multiple threads with the same context.
+     * 
+     * @param context 
+     * @param ranges 
+     * @param n 
+     * @param out_mask 
+     */
+    CROSS_PLATFORM_API void isGeneJudge(void *context, const gene::GeneRange *ranges, size_t n, uint8_t *out_mask);
+
+    /**
+     * @brief Release a context
+     * 
+     * @param context 
+     */
+    CROSS_PLATFORM_API void isGeneRelease(void *context);
+
+    /**
+     * @brief Optional cost hint. Estimate relative judge cost of n ranges
+     *        of the sequence of context, the driver uses it to split ORFs
+     *        across processes and threads. Length of range is used if it
+     *        is missing.
+     * 
+     * @param context 
+     * @param ranges 
+     * @param n 
+     * @param out_cost 
+     */
+    CROSS_PLATFORM_API void isGeneCost(void *context, const gene::GeneRange *ranges, size_t n, double *out_cost);
+}
+
 #endif //_GENE_JUDGE_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+#ifndef _BOUNDED_QUEUE_H
+#define _BOUNDED_QUEUE_H
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <stdint.h>
+
+namespace gene
+{
+    /**
+     * @brief A bounded lock-free queue for multiple producers and
+     *        consumers. Every cell has a sequence number that tells if it
+     *        is ready for push or pop of a position, so producers and
+     *        consumers only race on a compare and swap of their own index.
+     *
+     *        Blocking push and pop back off with yield and short sleeps,
+     *        so a full queue slows down producer, and an idle consumer
+     *        does not take a core from compute threads.
+     *
+     * @tparam T    Movable value type
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        std::atomic<bool> closed;
+
+        /**
+         * @brief Wait a while after failed try, longer after more tries
+         *
+         * @param tries
+         */
+        static void backOff(size_t tries)
+        {
+            if (tries < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(tries < 256 ? 50 : 1000));
+        }
+
+    public:
+        /**
+         * @brief Construct a new Bounded Queue object
+         *
+         * @param capacity  Rounded up to a power of 2
+         */
+        explicit BoundedQueue(size_t capacity)
+            : head(0), tail(0), closed(false)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+            this->cells.reset(new Cell[size]);
+            this->mask = size - 1;
+            for (size_t i = 0; i < size; ++i)
+                this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        BoundedQueue(const BoundedQueue &) = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+        /**
+         * @brief Push value if queue is not full
+         *
+         * @param value     Moved into queue on success
+         * @return true     Value is pushed.
+         * @return false    Queue is full.
+         */
+        bool tryPush(T &value)
+        {
+            size_t pos = this->head.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;)
+            {
+                cell = &this->cells[pos & this->mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0)
+                {
+                    if (this->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = this->head.load(std::memory_order_relaxed);
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+        /**
+         * @brief Pop value if queue is not empty
+         *
+         * @param value
+         * @return true     Value is popped.
+         * @return false    Queue is empty.
+         */
+        bool tryPop(T &value)
+        {
+            size_t pos = this->tail.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;)
+            {
+                cell = &this->cells[pos & this->mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (diff == 0)
+                {
+                    if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = this->tail.load(std::memory_order_relaxed);
+            }
+            value = std::move(cell->value);
+            cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+            return true;
+        }
+        /**
+         * @brief Push value, wait while queue is full
+         *
+         * @param value
+         * @return true     Value is pushed.
+         * @return false    Queue is closed.
+         */
+        bool push(T value)
+        {
+            for (size_t tries = 0; !this->tryPush(value); ++tries)
+            {
+                if (this->closed.load(std::memory_order_acquire))
+                    return false;
+                backOff(tries);
+            }
+            return true;
+        }
+        /**
+         * @brief Pop value, wait while queue is empty and not closed
+         *
+         * @param value
+         * @return true     Value is popped.
+         * @return false    Queue is closed and empty.
+         */
+        bool pop(T &value)
+        {
+            for (size_t tries = 0; !this->tryPop(value); ++tries)
+            {
+                // Values pushed before close are still popped
+                if (this->closed.load(std::memory_order_acquire))
+                    return this->tryPop(value);
+                backOff(tries);
+            }
+            return true;
+        }
+        /**
+         * @brief Close queue, no more values will be pushed
+         */
+        void close()
+        {
+            this->closed.store(true, std::memory_order_release);
+        }
+    };
+}
+#endif
@@ -0,0 +1,52 @@
+#include "Checkpoint.h"
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+const char *CHECKPOINT_HEADER = "gene_finder checkpoint 1";
+
+gene::Checkpoint::Checkpoint(const std::string &output, const std::string &fingerprint)
+    : path(output + ".ckpt"), fingerprint(fingerprint)
+{
+}
+
+bool gene::Checkpoint::load(size_t &records, uint64_t &offset) const
+{
+    std::ifstream in(this->path);
+    std::string header, fingerprint, line;
+    if (!std::getline(in, header) || header != CHECKPOINT_HEADER ||
+        !std::getline(in, fingerprint) || fingerprint != this->fingerprint ||
+        !std::getline(in, line))
+        return false;
+    std::istringstream fields(line);
+    return (bool)(fields >> records >> offset);
+}
+
+bool gene::Checkpoint::save(size_t records, uint64_t offset) const
+{
+    auto temp = this->path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << CHECKPOINT_HEADER << '\n'
+            << this->fingerprint << '\n'
+            << records << ' ' << offset << '\n';
+        out.close();
+        if (out.fail())
+            return false;
+    }
+    // Rename replaces old manifest atomically
+    std::error_code error;
+    std::filesystem::rename(temp, this->path, error);
+    return !error;
+}
+
+void gene::Checkpoint::remove() const
+{
+    std::error_code error;
+    std::filesystem::remove(this->path, error);
+}
+
+const std::string &gene::Checkpoint::getPath() const
+{
+    return this->path;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+#include <string>
+#include <stdint.h>
+
+namespace gene
+{
+    /**
+     * @brief Checkpoint manifest of an output file. It records how many
+     *        records of input are saved, and size of output after them.
+     *        Manifest is saved next to output as <output>.ckpt, by writing
+     *        a temporary file and renaming it, so it is never seen half
+     *        written. A fingerprint of input and options is saved with it,
+     *        so a manifest of another run is not used.
+     */
+    class Checkpoint
+    {
+    private:
+        std::string path;
+        std::string fingerprint;
+
+    public:
+        /**
+         * @brief Construct a new Checkpoint object
+         *
+         * @param output        Path of output file
+         * @param fingerprint   Input and options that change output, in
+         *                      one line
+         */
+        Checkpoint(const std::string &output, const std::string &fingerprint);
+        /**
+         * @brief Load saved progress
+         *
+         * @param records   Number of records saved to output
+         * @param offset    Size of output after them
+         * @return true     Progress is loaded.
+         * @return false    Manifest is missing, invalid or of another run.
+         */
+        bool load(size_t &records, uint64_t &offset) const;
+        /**
+         * @brief Save progress atomically
+         *
+         * @param records   Number of records saved to output
+         * @param offset    Size of output after them
+         * @return true     Operation sucessful.
+         * @return false    Operation failed.
+         */
+        bool save(size_t records, uint64_t offset) const;
+        /**
+         * @brief Remove manifest
+         */
+        void remove() const;
+        /**
+         * @brief Get path of manifest
+         *
+         * @return const std::string&
+         */
+        const std::string &getPath() const;
+    };
+}
+#endif
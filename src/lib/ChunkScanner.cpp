@@ -0,0 +1,125 @@
+#include "ChunkScanner.h"
+#include "Codon.h"
+#include <algorithm>
+
+gene::ChunkScanner::ChunkScanner(size_t length, size_t context,
+                                 ScanMode mode, bool packed)
+    : length(length), context((context + 2) / 3 * 3), mode(mode),
+      packed(packed), window("", ""), offset(0), head(0), previousEnd(0), pendingStart(length)
+{
+}
+
+size_t gene::ChunkScanner::getReadSize(size_t chunkSize) const
+{
+    size_t end = this->offset + this->window.getSequence().length();
+    chunkSize = std::max<size_t>(chunkSize, 3);
+    if (this->length - end <= chunkSize)
+        return this->length - end;
+    // (end + size) % 3 == length % 3
+    return chunkSize - (end + chunkSize + 3 - this->length % 3) % 3;
+}
+
+void gene::ChunkScanner::push(const Sequence &chunk)
+{
+    auto data = this->window.takeSequence();
+    data.append(chunk.getSequence());
+    this->window = Sequence(chunk.getLabel(), std::move(data));
+    if (this->packed)
+        this->window.pack();
+}
+
+std::vector<gene::GeneRange> gene::ChunkScanner::getORFS(int8_t frame)
+{
+    size_t l = this->window.getSequence().length();
+    size_t end = this->offset + l;
+    bool last = this->isLast();
+    std::vector<GeneRange> result;
+    for (auto &orf : gene::getORFS(this->window, frame, this->head, l, this->mode))
+    {
+        size_t start = orf.abs_start() + this->offset;
+        size_t stop = orf.abs_end() + this->offset;
+        bool hasHead = this->offset + this->head == 0 || orf.abs_start() >= this->head + this->context;
+        bool hasTail = last || stop + this->context < end;
+        if (!hasTail)
+            this->pendingStart = std::min(this->pendingStart, start);
+        // ORF is returned by previous window
+        if (stop + this->context < this->previousEnd)
+            continue;
+        if (hasHead && hasTail)
+            result.push_back(orf);
+    }
+    return result;
+}
+
+void gene::ChunkScanner::advance()
+{
+    const auto &table = gene::codon::table;
+    const auto &data = this->window.getSequence();
+    size_t l = data.length(), live = l - this->head;
+    // ORFs of later windows start at a start codon after the last stop
+    // codon of forward frames, end at the last stop codon of reverse
+    // frames, or start after codons at the end of window, that are not
+    // seen by getORFS on window.
+    size_t keep = std::min(this->pendingStart - this->offset, this->head + (live >= 3 ? live - 3 : 0));
+    bool forward[3] = {false, false, false}, reverse[3] = {false, false, false};
+    int found = 0;
+    for (size_t o = l - 3; live >= 3 && found < 6; --o)
+    {
+        uint8_t a = table.code[(uint8_t)data[o]];
+        uint8_t b = table.code[(uint8_t)data[o + 1]];
+        uint8_t c = table.code[(uint8_t)data[o + 2]];
+        uint8_t codon = (a | b | c) & gene::codon::BASE_INVALID
+                            ? gene::codon::INVALID_CODON
+                            : a << 4 | b << 2 | c;
+        // Codon at the end is not seen by forward frames, at the
+        // beginning is not seen by reverse frames
+        if (o + 4 <= l && !forward[o % 3])
+        {
+            if (gene::codon::isStop(codon))
+            {
+                forward[o % 3] = true;
+                ++found;
+            }
+            else if (gene::codon::isStart(codon))
+                keep = std::min(keep, o);
+        }
+        if (o > this->head && !reverse[o % 3] && codon != gene::codon::INVALID_CODON &&
+            gene::codon::isStop(table.reverseComplement[codon]))
+        {
+            reverse[o % 3] = true;
+            keep = std::min(keep, o);
+            ++found;
+        }
+        if (o == this->head)
+            break;
+    }
+    size_t drop = keep >= this->head + this->context ? (keep - this->head - this->context) / 3 * 3 : 0;
+    this->previousEnd = this->offset + l;
+    this->pendingStart = this->length;
+    this->head += drop;
+    // Erase dropped bases only when they are half of window, so a window
+    // is not copied for every chunk
+    if (this->head == 0 || this->head * 2 < l)
+        return;
+    auto label = this->window.getLabel();
+    auto rest = this->window.takeSequence();
+    rest.erase(0, this->head);
+    this->offset += this->head;
+    this->head = 0;
+    this->window = Sequence(label, std::move(rest));
+}
+
+const Sequence &gene::ChunkScanner::getWindow() const
+{
+    return this->window;
+}
+
+size_t gene::ChunkScanner::getOffset() const
+{
+    return this->offset;
+}
+
+bool gene::ChunkScanner::isLast() const
+{
+    return this->offset + this->window.getSequence().length() == this->length;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef _CHUNK_SCANNER_H
+#define _CHUNK_SCANNER_H
+#include <vector>
+#include <string>
+#include "Sequence.h"
+#include "GeneRange.h"
+#include "orf_finder.h"
+
+namespace gene
+{
+    /**
+     * @brief Scan ORFs of a record chunk by chunk. Chunks are appended to
+     *        a window, and the window only keeps the part of record that
+     *        ORFs of later chunks may still use, so memory is bounded by
+     *        chunk size, context and the longest open reading frame,
+     *        instead of record length.
+     *
+     *        Every ORF of the record is returned exactly once, with the
+     *        same frame as getORFS on the whole record, when the window
+     *        has at least context bases on both sides of it (or it is at
+     *        the border of record). Gene judge gives same result on the
+     *        window as on the whole record, if it only looks at bases
+     *        within context of the ORF.
+     */
+    class ChunkScanner
+    {
+    private:
+        size_t length;
+        size_t context;
+        ScanMode mode;
+        bool packed;
+        Sequence window;
+        // Position of window in record
+        size_t offset;
+        // Bases at the start of window that are not needed any more, they
+        // are erased when they are half of window, so chunks are appended
+        // in place
+        size_t head;
+        // End of previous window, ORFs that end before it were returned
+        size_t previousEnd;
+        // Smallest start of ORFs found but not returned yet
+        size_t pendingStart;
+
+    public:
+        /**
+         * @brief Construct a new Chunk Scanner object
+         *
+         * @param length    Length of record
+         * @param context   Bases kept around ORF for gene judge, it is
+         *                  rounded up to multiple of 3.
+         * @param mode      Scanning engine
+         * @param packed    Use 2-bit packed representation of windows
+         */
+        ChunkScanner(size_t length, size_t context,
+                     ScanMode mode = ScanMode::Linear, bool packed = false);
+        /**
+         * @brief Get number of bases to read for next chunk, at most
+         *        chunkSize. Window end is kept in same phase as record
+         *        end, so reverse frames of window match the record.
+         *
+         * @param chunkSize     Max size of chunk, at least 3.
+         * @return size_t
+         */
+        size_t getReadSize(size_t chunkSize) const;
+        /**
+         * @brief Append next chunk of record to window, window takes the
+         *        label of chunk.
+         *
+         * @param chunk
+         */
+        void push(const Sequence &chunk);
+        /**
+         * @brief Get ORFs of a frame that are ready to judge in current
+         *        window, in window coordinates.
+         *
+         * @param frame
+         * @return std::vector<GeneRange>
+         */
+        std::vector<GeneRange> getORFS(int8_t frame);
+        /**
+         * @brief Drop the part of window that is not needed by later
+         *        chunks. Call it after all frames of window are scanned.
+         */
+        void advance();
+        /**
+         * @brief Get current window, its first bases may be dropped ones
+         *        that no returned ORF uses
+         *
+         * @return const Sequence&
+         */
+        const Sequence &getWindow() const;
+        /**
+         * @brief Get position of window in record
+         *
+         * @return size_t
+         */
+        size_t getOffset() const;
+        /**
+         * @brief Check if window reaches the end of record
+         *
+         * @return true
+         * @return false
+         */
+        bool isLast() const;
+    };
+}
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef _CODON_H
+#define _CODON_H
+#include <stdint.h>
+
+namespace gene
+{
+    namespace codon
+    {
+        /**
+         * @brief 2-bit code of bases. T and U are same base in the code.
+         */
+        const uint8_t BASE_A = 0;
+        const uint8_t BASE_C = 1;
+        const uint8_t BASE_G = 2;
+        const uint8_t BASE_T = 3;
+        /**
+         * @brief Code of character that is not a ACGTU base
+         *        (N, gap, IUPAC or lower case character).
+         */
+        const uint8_t BASE_INVALID = 4;
+
+        /**
+         * @brief Codon code for codon that contains a invalid base.
+         *        Valid codon code is b0 << 4 | b1 << 2 | b2.
+         */
+        const uint8_t INVALID_CODON = 0x40;
+        /**
+         * @brief Bitmask of start codon code (AUG)
+         */
+        const uint64_t START_CODON_MASK = 1ULL << 0x0E;
+        /**
+         * @brief Bitmask of stop codon code (UAA, UAG, UGA)
+         */
+        const uint64_t STOP_CODON_MASK = (1ULL << 0x30) | (1ULL << 0x32) | (1ULL << 0x38);
+
+        /**
+         * @brief Lookup tables of base code, complement base code and
+         *        reverse complement codon code.
+         */
+        struct CodeTable
+        {
+            uint8_t code[256];
+            uint8_t complement[256];
+            uint8_t reverseComplement[64];
+            CodeTable()
+            {
+                for (int i = 0; i < 256; ++i)
+                    code[i] = complement[i] = BASE_INVALID;
+                code['A'] = BASE_A;
+                code['C'] = BASE_C;
+                code['G'] = BASE_G;
+                code['T'] = code['U'] = BASE_T;
+                for (int i = 0; i < 256; ++i)
+                    if (code[i] != BASE_INVALID)
+                        complement[i] = 3 - code[i];
+                for (int i = 0; i < 64; ++i)
+                    reverseComplement[i] = (3 - (i & 3)) << 4 |
+                                           (3 - ((i >> 2) & 3)) << 2 |
+                                           (3 - (i >> 4));
+            }
+        };
+        inline const CodeTable table;
+
+        /**
+         * @brief Check if codon code is start codon
+         *
+         * @param codon
+         * @return true
+         * @return false
+         */
+        inline bool isStart(uint8_t codon)
+        {
+            return codon < 64 && ((START_CODON_MASK >> codon) & 1);
+        }
+
+        /**
+         * @brief Check if codon code is stop codon
+         *
+         * @param codon
+         * @return true
+         * @return false
+         */
+        inline bool isStop(uint8_t codon)
+        {
+            return codon < 64 && ((STOP_CODON_MASK >> codon) & 1);
+        }
+    }
+}
+#endif
@@ -1,14 +1,54 @@
 #include "Fasta.h"
+#include "Profile.h"
 #include <sstream>
 #include <string>
 #include <algorithm>
-#include <omp.h>
+#include <filesystem>
+
+/**
+ * @brief Trim CR of CRLF line
+ *
+ * @param line
+ */
+inline void trimCR(std::string &line)
+{
+    if (line.length() != 0 &&
+        line[line.length() - 1] == '\r')
+        line.pop_back();
+}
+
+/**
+ * @brief Get bytes of a line read by getline from file, with line break
+ *
+ * @param line      Line before trimCR
+ * @param in
+ * @return uint64_t
+ */
+inline uint64_t lineBytes(const std::string &line, const std::istream &in)
+{
+    return line.length() + (in.eof() ? 0 : 1);
+}
+
+/**
+ * @brief Standarize sequence line, upper case and '-' for gap
+ *
+ * @param line
+ */
+inline void standardize(std::string &line)
+{
+    for (int i = 0; i < line.length(); ++i)
+    {
+        line[i] = line[i] == '_' ? '-' : (char)std::toupper(line[i]);
+    }
+}
 
 
 Fasta::Fasta(const char *filename, std::ios_base::openmode mode)
 {
     this->filename = filename;
     this->file = std::fstream(filename, mode);
+    this->pendingPos = 0;
+    this->indexed = false;
     // Get first sequence label
     if ((mode & std::ios::in) != 0)
         while (std::getline(this->file, this->label))
@@ -46,18 +86,31 @@ bool Fasta::write(const Sequence &seq, size_t lineWidth)
     if (!this->file.is_open())
         return false;
     // Print label
-    this->file << '>' << seq.getLabel() << std::endl;
-    // Print sequence
-    auto sequence = seq.getSequence();
-    for (int64_t i = 0; i < sequence.length(); i += lineWidth)
-        if (!(this->file << sequence.substr(i, lineWidth) << std::endl))
+    this->file << '>' << seq.getLabel() << '\n';
+    // Print sequence, lines are written from sequence buffer without
+    // flushing the file
+    const auto &sequence = seq.getSequence();
+    if (lineWidth == 0)
+        lineWidth = sequence.length();
+    for (size_t i = 0; i < sequence.length(); i += lineWidth)
+        if (!this->file.write(sequence.data() + i, std::min(lineWidth, sequence.length() - i)).put('\n'))
             return false;
     // Return sucessful
     return true;
 }
 
+bool Fasta::writeRaw(const std::string &data)
+{
+    if (!this->file.is_open())
+        return false;
+    gene::profile::Scope scope(gene::profile::Write);
+    gene::profile::count(gene::profile::BytesWritten, data.length());
+    return (bool)this->file.write(data.data(), data.length());
+}
+
 Sequence Fasta::getNextSequence()
 {
+    gene::profile::Scope scope(gene::profile::Read);
     // File not open
     if (!this->file.is_open())
     {
@@ -68,39 +121,236 @@ Sequence Fasta::getNextSequence()
     {
         return Sequence(true);
     }
-    std::ostringstream seq;
+    std::string seq;
     std::string line;
+    uint64_t bytes = 0;
     while (std::getline(this->file, line))
     {
+        bytes += lineBytes(line, this->file);
         // Trim CRLF
-        if (line.length() != 0 &&
-            line[line.length() - 1] == '\r')
-        {
-            line = line.substr(0, line.length() - 1);
-        }
+        trimCR(line);
         // If got new label line, return last sequence
         if (line[0] == '>')
         {
-            auto result = Sequence(this->label, seq.str());
+            gene::profile::count(gene::profile::BasesRead, seq.length());
+            gene::profile::count(gene::profile::BytesRead, bytes);
+            auto result = Sequence(this->label, std::move(seq));
             this->label = line.substr(1, line.length() - 1);
             return result;
         }
         // Standarize sequence
-        #pragma omp parallel for
-        for (int i = 0; i < line.length(); ++i)
-        {
-            line[i] = line[i] == '_' ? '-' : (char)std::toupper(line[i]);
-        }
+        standardize(line);
         // Build sequence
-        seq << line;
+        seq.append(line);
     }
     // Deal with last sequence
-    if (seq.str().length() != 0 || this->label.length() != 0)
+    gene::profile::count(gene::profile::BytesRead, bytes);
+    if (seq.length() != 0 || this->label.length() != 0)
     {
-        auto result = Sequence(this->label, seq.str());
+        gene::profile::count(gene::profile::BasesRead, seq.length());
+        auto result = Sequence(this->label, std::move(seq));
         this->label = "";
         return result;
     }
     // File is eof
     return Sequence(true);
+}
+
+bool Fasta::readPending(std::string &nextLabel)
+{
+    std::string line;
+    uint64_t bytes = 0;
+    while (std::getline(this->file, line))
+    {
+        bytes += lineBytes(line, this->file);
+        trimCR(line);
+        if (line.length() != 0 && line[0] == '>')
+        {
+            gene::profile::count(gene::profile::BytesRead, bytes);
+            nextLabel = line.substr(1, line.length() - 1);
+            return false;
+        }
+        if (line.length() == 0)
+            continue;
+        gene::profile::count(gene::profile::BytesRead, bytes);
+        standardize(line);
+        this->pending = std::move(line);
+        this->pendingPos = 0;
+        return true;
+    }
+    gene::profile::count(gene::profile::BytesRead, bytes);
+    nextLabel = "";
+    return false;
+}
+
+Sequence Fasta::getNextChunk(size_t chunkSize, bool &last)
+{
+    gene::profile::Scope scope(gene::profile::Read);
+    // File not open, or file is eof
+    if (!this->file.is_open() ||
+        (this->file.eof() && this->pendingPos >= this->pending.length() &&
+         this->label.length() == 0))
+        return Sequence(true);
+    std::string chunk;
+    std::string nextLabel;
+    bool recordEnd = false;
+    // Take bases from pending line, until chunk is full
+    while (!recordEnd)
+    {
+        if (this->pendingPos >= this->pending.length() &&
+            !this->readPending(nextLabel))
+        {
+            recordEnd = true;
+            break;
+        }
+        if (chunk.length() == chunkSize)
+            break;
+        auto count = std::min(chunkSize - chunk.length(),
+                              this->pending.length() - this->pendingPos);
+        chunk.append(this->pending, this->pendingPos, count);
+        this->pendingPos += count;
+    }
+    // Deal with empty record at the end of file
+    if (recordEnd && this->file.eof() && chunk.length() == 0 && this->label.length() == 0)
+        return Sequence(true);
+    gene::profile::count(gene::profile::BasesRead, chunk.length());
+    auto result = Sequence(this->label, std::move(chunk));
+    last = recordEnd;
+    if (recordEnd)
+        this->label = nextLabel;
+    return result;
+}
+
+std::vector<size_t> Fasta::getRecordLengths() const
+{
+    std::vector<size_t> lengths;
+    std::ifstream in(this->filename);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        trimCR(line);
+        if (line.length() != 0 && line[0] == '>')
+            lengths.push_back(0);
+        else if (!lengths.empty())
+            lengths.back() += line.length();
+    }
+    return lengths;
+}
+
+bool Fasta::readLabel(uint64_t offset, std::string &label) const
+{
+    std::ifstream in(this->filename, std::ios::binary);
+    if (!in.is_open() || !in.seekg(0, std::ios::end) || (uint64_t)in.tellg() < offset)
+        return false;
+    // Read backward block by block, until line break before label line
+    std::string buffer;
+    for (uint64_t pos = offset; pos > 0;)
+    {
+        uint64_t n = std::min<uint64_t>(pos, 256);
+        pos -= n;
+        std::string block(n, '\0');
+        in.seekg(pos);
+        if (!in.read(&block[0], n))
+            return false;
+        buffer.insert(0, block);
+        // Label line of last record may have no line break
+        size_t body = buffer.length() - (offset != 0 && buffer.back() == '\n');
+        size_t lineStart = body == 0 ? std::string::npos : buffer.rfind('\n', body - 1);
+        if (lineStart != std::string::npos || pos == 0)
+        {
+            lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+            label = buffer.substr(lineStart, body - lineStart);
+            break;
+        }
+    }
+    trimCR(label);
+    if (label.length() == 0 || label[0] != '>')
+        return false;
+    label.erase(0, 1);
+    return true;
+}
+
+const FastaIndex &Fasta::getIndex()
+{
+    if (this->indexed)
+        return this->index;
+    this->indexed = true;
+    namespace fs = std::filesystem;
+    std::string faiPath = this->filename + ".fai";
+    std::error_code ec, faiEc;
+    auto modified = fs::last_write_time(this->filename, ec);
+    auto faiModified = fs::last_write_time(faiPath, faiEc);
+    // Reuse .fai file, if it is up to date and matches label lines
+    if (!ec && !faiEc && faiModified >= modified && this->index.load(faiPath.c_str()))
+    {
+        bool valid = true;
+        for (size_t i = 0; valid && i < this->index.size(); ++i)
+        {
+            std::string label;
+            valid = this->readLabel(this->index[i].offset, label) &&
+                    FastaIndex::getName(label) == this->index[i].label;
+            this->index[i].label = label;
+        }
+        if (valid)
+            return this->index;
+    }
+    std::ifstream in(this->filename, std::ios::binary);
+    this->index = FastaIndex(in);
+    this->index.save(faiPath.c_str());
+    return this->index;
+}
+
+Sequence Fasta::getRegion(size_t record, size_t start, size_t end)
+{
+    gene::profile::Scope scope(gene::profile::Read);
+    const auto &index = this->getIndex();
+    if (record >= index.size() || !this->file.is_open())
+        return Sequence(true);
+    const auto &entry = index[record];
+    end = std::min<size_t>(end, entry.length);
+    start = std::min(start, end);
+    std::string bases;
+    bases.reserve(end - start);
+    this->file.clear();
+    // Fixed line width, base p is at offset + p / lineBases * lineBytes + p % lineBases
+    if (entry.lineBases != 0)
+    {
+        if (start == end)
+            return Sequence(entry.label, std::move(bases));
+        auto byteOf = [&entry](uint64_t p)
+        { return entry.offset + p / entry.lineBases * entry.lineBytes + p % entry.lineBases; };
+        uint64_t first = byteOf(start), last = byteOf(end - 1) + 1;
+        std::string raw(last - first, '\0');
+        this->file.seekg(first);
+        if (!this->file.read(&raw[0], raw.length()))
+            return Sequence(true);
+        for (auto c : raw)
+            if (c != '\n' && c != '\r')
+                bases.push_back(c);
+        standardize(bases);
+        gene::profile::count(gene::profile::BasesRead, bases.length());
+        gene::profile::count(gene::profile::BytesRead, raw.length());
+        return Sequence(entry.label, std::move(bases));
+    }
+    // Walk lines of record
+    this->file.seekg(entry.offset);
+    std::string line;
+    uint64_t bytes = 0;
+    for (size_t pos = 0; pos < end && std::getline(this->file, line);)
+    {
+        bytes += lineBytes(line, this->file);
+        trimCR(line);
+        if (line.length() != 0 && line[0] == '>')
+            break;
+        if (pos + line.length() > start)
+        {
+            size_t skip = pos < start ? start - pos : 0;
+            bases.append(line, skip, std::min(line.length(), end - pos) - skip);
+        }
+        pos += line.length();
+    }
+    standardize(bases);
+    gene::profile::count(gene::profile::BasesRead, bases.length());
+    gene::profile::count(gene::profile::BytesRead, bytes);
+    return Sequence(entry.label, std::move(bases));
 }
\ No newline at end of file
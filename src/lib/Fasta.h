@@ -6,7 +6,9 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <vector>
 #include "Sequence.h"
+#include "FastaIndex.h"
 
 /**
  * @brief  A fasta file object, that parse fasta file.
@@ -17,6 +19,30 @@ private:
     std::fstream file;
     std::string filename;
     std::string label;
+    // Bases of current line, that are not returned by getNextChunk
+    std::string pending;
+    size_t pendingPos;
+    // Index of records, built or loaded by getIndex
+    FastaIndex index;
+    bool indexed;
+
+    /**
+     * @brief Read next line of sequence into pending buffer
+     *
+     * @param nextLabel     Set to label of next record if got a label line
+     * @return true         Got a line of sequence.
+     * @return false        Got a label line or end of file.
+     */
+    bool readPending(std::string &nextLabel);
+    /**
+     * @brief Read label line that ends right before a byte offset
+     *
+     * @param offset    Byte offset of first base of a record
+     * @param label     Label without '>'
+     * @return true     Got a label line.
+     * @return false    Line before offset is not a label line.
+     */
+    bool readLabel(uint64_t offset, std::string &label) const;
 
 public:
     /**
@@ -44,12 +70,63 @@ public:
      * @return false        Operation failed.
      */
     bool write(const Sequence &seq, size_t lineWidth = 70);
+    /**
+     * @brief Write formatted fasta records to file as they are
+     *
+     * @param data
+     * @return true         Operation sucessful.
+     * @return false        Operation failed.
+     */
+    bool writeRaw(const std::string &data);
     /**
      * @brief Get the Next Sequence object
      *
      * @return Sequence
      */
     Sequence getNextSequence();
+    /**
+     * @brief Get the next chunk of sequence. A chunk contains at most
+     *        chunkSize bases of a record, and chunks of a record are
+     *        returned in order before the chunks of next record. Memory
+     *        used by reading is bounded by chunkSize and line length.
+     *
+     * @param chunkSize     Max number of bases in the chunk
+     * @param last          Set to true, if it is the last chunk of record
+     * @return Sequence     Chunk with label of the record. Invalid
+     *                      sequence at the end of file.
+     */
+    Sequence getNextChunk(size_t chunkSize, bool &last);
+    /**
+     * @brief Get the length of every record by reading the file once,
+     *        without storing the sequences.
+     *
+     * @return std::vector<size_t>
+     */
+    std::vector<size_t> getRecordLengths() const;
+    /**
+     * @brief Get index of records. The index is loaded from .fai file
+     *        next to the fasta file, if it is not older than the fasta
+     *        file and its names match the label lines. Otherwise it is
+     *        built by reading the file once, and saved as .fai file if
+     *        the directory is writable and every record has lines of
+     *        same width.
+     *
+     * @return const FastaIndex&    Entries have full label lines.
+     */
+    const FastaIndex &getIndex();
+    /**
+     * @brief Get bases [start, end) of a record by seeking to them with
+     *        the index, same as the bases returned by getNextSequence.
+     *        It moves read position of the file, so it should not be
+     *        mixed with getNextSequence and getNextChunk.
+     *
+     * @param record    Index of record
+     * @param start
+     * @param end
+     * @return Sequence     Region with label of the record. Invalid
+     *                      sequence if record does not exist.
+     */
+    Sequence getRegion(size_t record, size_t start, size_t end);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "FastaIndex.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unistd.h>
+
+/**
+ * @brief Builds entries of index line by line
+ */
+struct IndexBuilder
+{
+    std::vector<FastaIndex::Entry> &entries;
+    FastaIndex::Entry *entry = nullptr;
+    // Width of last line, line after a short line makes record irregular
+    uint64_t lastBases = 0, lastBytes = 0;
+
+    /**
+     * @brief Add a line of file
+     *
+     * @param line      Line content without line break
+     * @param bases     Length of line content
+     * @param bytes     Length of line, with line break
+     * @param next      Byte offset of next line in file
+     */
+    void add(const char *line, uint64_t bases, uint64_t bytes, uint64_t next)
+    {
+        if (bases != 0 && line[0] == '>')
+        {
+            this->entries.push_back({std::string(line + 1, bases - 1), 0, next, 0, 0});
+            this->entry = &this->entries.back();
+            this->lastBases = this->lastBytes = 0;
+        }
+        else if (this->entry != nullptr)
+        {
+            if (this->entry->length == 0 && this->entry->lineBytes == 0)
+            {
+                this->entry->lineBases = bases;
+                this->entry->lineBytes = bytes;
+            }
+            else if (bases != 0 && (this->lastBases != this->entry->lineBases ||
+                                    this->lastBytes != this->entry->lineBytes ||
+                                    bases > this->entry->lineBases))
+                this->entry->lineBases = 0;
+            this->entry->length += bases;
+            this->lastBases = bases;
+            this->lastBytes = bytes;
+        }
+    }
+
+    /**
+     * @brief Finish the last record
+     */
+    void finish()
+    {
+        // Empty record without label at the end is not a record
+        if (!this->entries.empty() && this->entries.back().label.length() == 0 &&
+            this->entries.back().length == 0)
+            this->entries.pop_back();
+    }
+};
+
+FastaIndex::FastaIndex(const char *data, size_t size)
+{
+    const char *end = data + size;
+    IndexBuilder builder{this->entries};
+    for (const char *line = data; line < end;)
+    {
+        const char *next = (const char *)std::memchr(line, '\n', end - line);
+        next = next == nullptr ? end : next + 1;
+        // Line content without line break, trim CR of CRLF
+        const char *stop = next[-1] == '\n' ? next - 1 : next;
+        if (stop > line && stop[-1] == '\r')
+            --stop;
+        builder.add(line, stop - line, next - line, next - data);
+        line = next;
+    }
+    builder.finish();
+}
+
+FastaIndex::FastaIndex(std::istream &in)
+{
+    IndexBuilder builder{this->entries};
+    uint64_t offset = 0;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        uint64_t bytes = line.length() + (in.eof() ? 0 : 1);
+        if (line.length() != 0 && line[line.length() - 1] == '\r')
+            line.pop_back();
+        offset += bytes;
+        builder.add(line.c_str(), line.length(), bytes, offset);
+    }
+    builder.finish();
+}
+
+size_t FastaIndex::size() const
+{
+    return this->entries.size();
+}
+
+const FastaIndex::Entry &FastaIndex::operator[](size_t record) const
+{
+    return this->entries[record];
+}
+
+FastaIndex::Entry &FastaIndex::operator[](size_t record)
+{
+    return this->entries[record];
+}
+
+std::string FastaIndex::getName(const std::string &label)
+{
+    return label.substr(0, label.find_first_of(" \t"));
+}
+
+bool FastaIndex::save(const char *path) const
+{
+    // samtools can not read rows of linebases 0, so irregular files are not saved
+    for (auto &entry : this->entries)
+        if (entry.lineBases == 0)
+            return false;
+    // Write a file of this process and rename it, so other runs never load a partial index
+    std::string temp = std::string(path) + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out.is_open())
+            return false;
+        for (auto &entry : this->entries)
+            out << getName(entry.label) << '\t' << entry.length << '\t' << entry.offset << '\t'
+                << entry.lineBases << '\t' << entry.lineBytes << '\n';
+        out.close();
+        if (out.fail())
+        {
+            std::error_code error;
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error)
+        std::filesystem::remove(temp, error);
+    return !error;
+}
+
+bool FastaIndex::load(const char *path)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+        return false;
+    std::vector<Entry> loaded;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.length() != 0 && line[line.length() - 1] == '\r')
+            line.pop_back();
+        if (line.length() == 0)
+            continue;
+        // name, length, offset, linebases, linebytes
+        auto tab = line.find('\t');
+        if (tab == std::string::npos)
+            return false;
+        Entry entry{line.substr(0, tab), 0, 0, 0, 0};
+        std::istringstream fields(line.substr(tab + 1));
+        if (!(fields >> entry.length >> entry.offset >> entry.lineBases >> entry.lineBytes))
+            return false;
+        loaded.push_back(std::move(entry));
+    }
+    this->entries = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef _FASTA_INDEX_H
+#define _FASTA_INDEX_H
+#include <string>
+#include <vector>
+#include <istream>
+#include <stdint.h>
+
+/**
+ * @brief Index of records in a fasta file, similar to a .fai index:
+ *        label, length, byte offset of first base and line width of
+ *        every record. It can be saved and loaded as a samtools
+ *        compatible .fai file.
+ */
+class FastaIndex
+{
+public:
+    /**
+     * @brief Index entry of a record
+     */
+    struct Entry
+    {
+        // Label line without '>'
+        std::string label;
+        // Number of bases
+        uint64_t length;
+        // Byte offset of first base in file
+        uint64_t offset;
+        // Bases per line, 0 if lines of record are not same width
+        uint64_t lineBases;
+        // Bytes per line, with line break
+        uint64_t lineBytes;
+    };
+
+private:
+    std::vector<Entry> entries;
+
+public:
+    /**
+     * @brief Build index from content of fasta file, records are parsed
+     *        same as Fasta::getNextSequence.
+     *
+     * @param data
+     * @param size
+     */
+    FastaIndex(const char *data, size_t size);
+    /**
+     * @brief Build index by reading a fasta file line by line
+     *
+     * @param in
+     */
+    explicit FastaIndex(std::istream &in);
+    /**
+     * @brief Construct a empty index
+     */
+    FastaIndex() = default;
+    /**
+     * @brief Get number of records
+     *
+     * @return size_t
+     */
+    size_t size() const;
+    /**
+     * @brief Get entry of a record
+     *
+     * @param record
+     * @return const Entry&
+     */
+    const Entry &operator[](size_t record) const;
+    /**
+     * @brief Get entry of a record
+     *
+     * @param record
+     * @return Entry&
+     */
+    Entry &operator[](size_t record);
+    /**
+     * @brief Get name of record in .fai file, the label until first
+     *        white space
+     *
+     * @param label
+     * @return std::string
+     */
+    static std::string getName(const std::string &label);
+    /**
+     * @brief Save index as .fai file, one line per record: name,
+     *        length, offset, linebases, linebytes separated by tab.
+     *        The file is written to a temporary file and renamed over
+     *        path, so a partial index is never seen by other runs.
+     *
+     * @param path
+     * @return true         Operation sucessful.
+     * @return false        Operation failed, or a record has lines of
+     *                      different width, which .fai can not store.
+     */
+    bool save(const char *path) const;
+    /**
+     * @brief Load index from .fai file. Label of entries is the name
+     *        of record, as .fai file does not store full label line.
+     *
+     * @param path
+     * @return true         Operation sucessful.
+     * @return false        File is missing or malformed, index is
+     *                      unchanged.
+     */
+    bool load(const char *path);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "FastaWriter.h"
+
+void FastaBuffer::appendBases(const char *bases, size_t n, size_t lineWidth)
+{
+    if (lineWidth == 0)
+        lineWidth = n;
+    if (n == 0)
+        return;
+    size_t size = this->buffer.size();
+    size_t lines = (n + lineWidth - 1) / lineWidth;
+    // Resize once, then copy every line and its line break into place
+    this->buffer.resize(size + n + lines);
+    char *out = &this->buffer[size];
+    for (size_t i = 0; i < n; i += lineWidth)
+    {
+        size_t count = std::min(lineWidth, n - i);
+        std::copy(bases + i, bases + i + count, out);
+        out[count] = '\n';
+        out += count + 1;
+    }
+}
+
+void FastaBuffer::append(const FastaBuffer &other)
+{
+    this->buffer.append(other.buffer);
+}
+
+const std::string &FastaBuffer::str() const
+{
+    return this->buffer;
+}
+
+size_t FastaBuffer::size() const
+{
+    return this->buffer.size();
+}
+
+void FastaBuffer::clear()
+{
+    this->buffer.clear();
+}
@@ -0,0 +1,151 @@
+#pragma once
+#ifndef _FASTA_WRITER_H
+#define _FASTA_WRITER_H
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+#include <omp.h>
+#include "Fasta.h"
+#include "Profile.h"
+
+/**
+ * @brief A memory buffer of formatted fasta records. Labels are printed
+ *        in place and bases are wrapped without intermediate strings, so
+ *        records are written to file by a few large writes.
+ */
+class FastaBuffer
+{
+private:
+    std::string buffer;
+
+public:
+    /**
+     * @brief Append label line of a record, formatted by printf pattern
+     *
+     * @tparam Args
+     * @param format
+     * @param args
+     */
+    template <typename... Args>
+    void appendLabel(const char *format, Args... args)
+    {
+        const size_t guess = 128;
+        size_t size = this->buffer.size();
+        this->buffer.resize(size + 1 + guess);
+        int n = std::snprintf(&this->buffer[size + 1], guess, format, args...);
+        if (n < 0)
+            throw std::runtime_error("Error during formatting.");
+        // Label is longer than guess, print it again
+        if ((size_t)n >= guess)
+        {
+            this->buffer.resize(size + 2 + n);
+            std::snprintf(&this->buffer[size + 1], n + 1, format, args...);
+        }
+        this->buffer[size] = '>';
+        this->buffer.resize(size + 1 + n);
+        this->buffer.push_back('\n');
+    }
+    /**
+     * @brief Append bases of a record, lineWidth bases per line
+     *
+     * @param bases
+     * @param n
+     * @param lineWidth     0 for no line wrapping
+     */
+    void appendBases(const char *bases, size_t n, size_t lineWidth = 70);
+    /**
+     * @brief Append formatted records of another buffer
+     *
+     * @param other
+     */
+    void append(const FastaBuffer &other);
+    /**
+     * @brief Get formatted records
+     *
+     * @return const std::string&
+     */
+    const std::string &str() const;
+    /**
+     * @brief Get size of formatted records in bytes
+     *
+     * @return size_t
+     */
+    size_t size() const;
+    /**
+     * @brief Remove all records, keep the memory for reuse
+     */
+    void clear();
+};
+
+/**
+ * @brief Format n records in parallel and write them to file in order.
+ *        In each round every thread formats a contiguous block of
+ *        records into its own buffer, then buffers are written in thread
+ *        order, so output is same as formatting records one by one.
+ *
+ * @tparam Format   Callable as format(i, FastaBuffer &out), that appends
+ *                  record i to out. It is called from multiple threads.
+ * @param file
+ * @param n         Number of records
+ * @param format
+ * @return true         Operation sucessful.
+ * @return false        Operation failed.
+ */
+template <typename Format>
+bool writeRecords(Fasta &file, size_t n, const Format &format)
+{
+    // Records formatted by each thread in a round
+    const size_t batch = 4096;
+    const int threads = omp_get_max_threads();
+    std::vector<FastaBuffer> buffers(threads);
+    gene::profile::count(gene::profile::Genes, n);
+    for (size_t base = 0; base < n; base += batch * threads)
+    {
+        size_t count = std::min(n - base, batch * threads);
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 0; t < threads; ++t)
+        {
+            gene::profile::Scope scope(gene::profile::Format);
+            auto &out = buffers[t];
+            out.clear();
+            for (size_t i = base + count * t / threads; i < base + count * (t + 1) / threads; ++i)
+                format(i, out);
+        }
+        for (auto &out : buffers)
+            if (!file.writeRaw(out.str()))
+                return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Format n records in parallel into a buffer, in order. Every
+ *        thread formats a contiguous block of records into its own
+ *        buffer, then buffers are appended in thread order.
+ *
+ * @tparam Format   Callable as format(i, FastaBuffer &out), that appends
+ *                  record i to out. It is called from multiple threads.
+ * @param out
+ * @param n         Number of records
+ * @param format
+ */
+template <typename Format>
+void formatRecords(FastaBuffer &out, size_t n, const Format &format)
+{
+    const int threads = omp_get_max_threads();
+    std::vector<FastaBuffer> buffers(threads);
+    gene::profile::count(gene::profile::Genes, n);
+    #pragma omp parallel for schedule(static, 1)
+    for (int t = 0; t < threads; ++t)
+    {
+        gene::profile::Scope scope(gene::profile::Format);
+        for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i)
+            format(i, buffers[t]);
+    }
+    for (auto &buffer : buffers)
+        out.append(buffer);
+}
+
+#endif
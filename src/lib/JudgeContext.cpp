@@ -0,0 +1,135 @@
+#include "JudgeContext.h"
+#include "gene_judge.h"
+#include "Profile.h"
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+/**
+ * @brief Optional batch API of gene judge library, resolved at runtime
+ */
+static const struct BatchApi
+{
+    decltype(&isGeneBatchVersion) version = nullptr;
+    decltype(&isGenePrepare) prepare = nullptr;
+    decltype(&isGeneJudge) judge = nullptr;
+    decltype(&isGeneRelease) release = nullptr;
+    // Optional cost hint of batch API
+    decltype(&isGeneCost) cost = nullptr;
+
+    /**
+     * @brief Find symbol in loaded libraries
+     *
+     * @tparam T
+     * @param name
+     * @param func
+     */
+    template <typename T>
+    static void find(const char *name, T &func)
+    {
+#ifdef _WIN32
+        func = (T)GetProcAddress(GetModuleHandleA("gene_judge.dll"), name);
+#else
+        func = (T)dlsym(RTLD_DEFAULT, name);
+#endif
+    }
+
+    BatchApi()
+    {
+        find("isGeneBatchVersion", version);
+        find("isGenePrepare", prepare);
+        find("isGeneJudge", judge);
+        find("isGeneRelease", release);
+        find("isGeneCost", cost);
+        // Fall back to isGene for old or incomplete library
+        if (version == nullptr || prepare == nullptr || judge == nullptr ||
+            release == nullptr || version() != GENE_JUDGE_BATCH_API_VERSION)
+            version = nullptr;
+    }
+
+    bool available() const
+    {
+        return version != nullptr;
+    }
+} batchApi;
+
+gene::JudgeContext::JudgeContext(const Sequence &seq) : seq(seq), context(nullptr)
+{
+    gene::profile::Scope scope(gene::profile::Prepare);
+    if (batchApi.available())
+        this->context = batchApi.prepare(&seq);
+}
+
+gene::JudgeContext::~JudgeContext()
+{
+    if (this->context != nullptr)
+        batchApi.release(this->context);
+}
+
+void gene::JudgeContext::judge(const GeneRange *ranges, size_t n, GeneRange *out) const
+{
+    gene::profile::Scope scope(gene::profile::Judge);
+    gene::profile::count(gene::profile::OrfsJudged, n);
+    if (this->context == nullptr)
+    {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = isGene(ranges[i], this->seq);
+        return;
+    }
+    std::unique_ptr<uint8_t[]> mask(new uint8_t[n]);
+    batchApi.judge(this->context, ranges, n, mask.get());
+    for (size_t i = 0; i < n; ++i)
+        out[i] = mask[i] ? ranges[i] : GeneRange{INVALID_RANGE_LOC, INVALID_RANGE_LOC, INVALID_FRAME};
+}
+
+bool gene::JudgeContext::hasBatchApi()
+{
+    return batchApi.available();
+}
+
+
+void gene::JudgeContext::cost(const GeneRange *ranges, size_t n, double *out) const
+{
+    if (this->context != nullptr && batchApi.cost != nullptr)
+    {
+        batchApi.cost(this->context, ranges, n, out);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i)
+        out[i] = ranges[i].length();
+}
+
+std::vector<size_t> gene::JudgeContext::splitBatches(const GeneRange *ranges, size_t n,
+                                                     size_t count) const
+{
+    std::vector<double> costs(n);
+    this->cost(ranges, n, costs.data());
+    double total = 0;
+    for (auto c : costs)
+        total += c;
+    // Hint without any cost, split by count
+    if (!(total > 0))
+    {
+        costs.assign(n, 1);
+        total = n;
+    }
+    // Close a batch when cost reaches next multiple of share of a batch
+    std::vector<size_t> bounds{0};
+    double share = total / std::max<size_t>(count, 1), sum = 0, next = share;
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+        sum += costs[i];
+        if (sum >= next)
+        {
+            bounds.push_back(i + 1);
+            next = (std::floor(sum / share) + 1) * share;
+        }
+    }
+    bounds.push_back(n);
+    return bounds;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef _JUDGE_CONTEXT_H
+#define _JUDGE_CONTEXT_H
+#include <vector>
+#include "Sequence.h"
+#include "GeneRange.h"
+
+namespace gene
+{
+    /**
+     * @brief Judge context of a sequence. It uses the batch API of gene
+     *        judge library if the library exports it, so judge can share
+     *        per-sequence precomputation across all frames. Otherwise it
+     *        calls isGene for each ORF.
+     */
+    class JudgeContext
+    {
+    private:
+        const Sequence &seq;
+        void *context;
+
+    public:
+        /**
+         * @brief Prepare judge context of a sequence. The sequence must
+         *        stay alive until the context is destroyed.
+         *
+         * @param seq
+         */
+        explicit JudgeContext(const Sequence &seq);
+        JudgeContext(const JudgeContext &) = delete;
+        JudgeContext &operator=(const JudgeContext &) = delete;
+        /**
+         * @brief Destroy the JudgeContext object, release the context
+         *        of judge library.
+         */
+        ~JudgeContext();
+        /**
+         * @brief Judge n ranges, out[i] is the result of isGene for
+         *        ranges[i]: the gene range, or a invalid range for non-gene
+         *        ORF. It can be called from multiple threads.
+         *
+         * @param ranges
+         * @param n
+         * @param out
+         */
+        void judge(const GeneRange *ranges, size_t n, GeneRange *out) const;
+        /**
+         * @brief Check if gene judge library exports the batch API
+         *
+         * @return true
+         * @return false
+         */
+        static bool hasBatchApi();
+        /**
+         * @brief Estimate judge cost of n ranges, by the cost hint of
+         *        gene judge library (isGeneCost) if it exports one with
+         *        the batch API, or by length of ranges.
+         *
+         * @param ranges
+         * @param n
+         * @param out
+         */
+        void cost(const GeneRange *ranges, size_t n, double *out) const;
+        /**
+         * @brief Split n ranges into about count batches of similar judge
+         *        cost, so threads get even work from dynamic scheduling.
+         *
+         * @param ranges
+         * @param n
+         * @param count
+         * @return std::vector<size_t>  Boundaries of batches, batch i is
+         *                              [bounds[i], bounds[i + 1]).
+         */
+        std::vector<size_t> splitBatches(const GeneRange *ranges, size_t n, size_t count) const;
+    };
+}
+#endif
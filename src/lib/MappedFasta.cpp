@@ -0,0 +1,146 @@
+#include "MappedFasta.h"
+#include "Profile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Copy bases and standardize them, upper case and '-' for gap.
+ *        Same as Fasta::getNextSequence, in a loop that can be vectorized.
+ *
+ * @param src
+ * @param n
+ * @param dst
+ */
+static inline void copyBases(const char *src, size_t n, char *dst)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        char c = src[i] == '_' ? '-' : src[i];
+        dst[i] = c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+    }
+}
+
+MappedFasta::MappedFasta(const char *filename) : data(nullptr), size(0)
+{
+#ifdef _WIN32
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open())
+        return;
+    this->buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        st.st_size = -1;
+    // Empty file has no mapping
+    if (st.st_size == 0)
+        this->data = "";
+    else if (st.st_size > 0)
+    {
+        void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            this->data = (const char *)map;
+            this->size = st.st_size;
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+#endif
+    if (this->data != nullptr)
+        this->index = FastaIndex(this->data, this->size);
+}
+
+MappedFasta::~MappedFasta()
+{
+#ifndef _WIN32
+    if (this->data != nullptr && this->size != 0)
+        munmap((void *)this->data, this->size);
+#endif
+}
+
+bool MappedFasta::isOpen() const
+{
+    return this->data != nullptr;
+}
+
+const FastaIndex &MappedFasta::getIndex() const
+{
+    return this->index;
+}
+
+Sequence MappedFasta::getSequence(size_t record) const
+{
+    if (record >= this->index.size())
+        return Sequence(true);
+    return this->getRegion(record, 0, this->index[record].length);
+}
+
+Sequence MappedFasta::getRegion(size_t record, size_t start, size_t end) const
+{
+    if (record >= this->index.size())
+        return Sequence(true);
+    gene::profile::Scope scope(gene::profile::Read);
+    const auto &entry = this->index[record];
+    end = std::min<size_t>(end, entry.length);
+    start = std::min(start, end);
+    gene::profile::count(gene::profile::BasesRead, end - start);
+    std::string bases(end - start, '\0');
+    char *out = &bases[0];
+    const char *fileEnd = this->data + this->size;
+    // Fixed line width, bases of line k start at offset + k * lineBytes
+    if (entry.lineBases != 0)
+    {
+        if (end > start)
+            gene::profile::count(gene::profile::BytesRead,
+                                 (end - 1) / entry.lineBases * entry.lineBytes + (end - 1) % entry.lineBases + 1 -
+                                     start / entry.lineBases * entry.lineBytes - start % entry.lineBases);
+        for (size_t pos = start; pos < end;)
+        {
+            size_t column = pos % entry.lineBases;
+            size_t n = std::min(end - pos, entry.lineBases - column);
+            copyBases(this->data + entry.offset + pos / entry.lineBases * entry.lineBytes + column,
+                      n, out);
+            out += n;
+            pos += n;
+        }
+        return Sequence(entry.label, std::move(bases));
+    }
+    // Walk lines of record
+    size_t pos = 0;
+    const char *line = this->data + entry.offset;
+    for (; line < fileEnd && pos < end;)
+    {
+        const char *next = (const char *)std::memchr(line, '\n', fileEnd - line);
+        next = next == nullptr ? fileEnd : next + 1;
+        const char *stop = next[-1] == '\n' ? next - 1 : next;
+        if (stop > line && stop[-1] == '\r')
+            --stop;
+        if (line[0] == '>')
+            break;
+        size_t length = stop - line;
+        if (pos + length > start)
+        {
+            size_t skip = pos < start ? start - pos : 0;
+            size_t n = std::min(length - skip, end - pos - skip);
+            copyBases(line + skip, n, out);
+            out += n;
+        }
+        pos += length;
+        line = next;
+    }
+    gene::profile::count(gene::profile::BytesRead, line - (this->data + entry.offset));
+    return Sequence(entry.label, std::move(bases));
+}
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef _MAPPED_FASTA_H
+#define _MAPPED_FASTA_H
+#include <string>
+#include "Sequence.h"
+#include "FastaIndex.h"
+
+/**
+ * @brief A memory mapped fasta file. Records are located by a FastaIndex,
+ *        and bases of a record or a region are copied out of the mapping
+ *        in one pass, which skips line breaks and standardizes bases.
+ *        Nothing is parsed until a record is read, so every MPI process
+ *        can map the file and read only the records it needs.
+ */
+class MappedFasta
+{
+private:
+    const char *data;
+    size_t size;
+    FastaIndex index;
+#ifdef _WIN32
+    std::string buffer;
+#endif
+
+public:
+    /**
+     * @brief Map a fasta file and build index of it
+     *
+     * @param filename
+     */
+    explicit MappedFasta(const char *filename);
+    MappedFasta(const MappedFasta &) = delete;
+    MappedFasta &operator=(const MappedFasta &) = delete;
+    /**
+     * @brief Destroy the Mapped Fasta object, unmap the file
+     */
+    ~MappedFasta();
+    /**
+     * @brief Check if the file is mapped
+     *
+     * @return true
+     * @return false
+     */
+    bool isOpen() const;
+    /**
+     * @brief Get index of the file
+     *
+     * @return const FastaIndex&
+     */
+    const FastaIndex &getIndex() const;
+    /**
+     * @brief Get a record, same as the record returned by
+     *        Fasta::getNextSequence
+     *
+     * @param record    Index of record
+     * @return Sequence
+     */
+    Sequence getSequence(size_t record) const;
+    /**
+     * @brief Get bases [start, end) of a record. Region of a record with
+     *        fixed line width is located directly, otherwise lines before
+     *        it are skipped.
+     *
+     * @param record    Index of record
+     * @param start
+     * @param end
+     * @return Sequence
+     */
+    Sequence getRegion(size_t record, size_t start, size_t end) const;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "PackedSequence.h"
+#include <algorithm>
+
+/**
+ * @brief Append a character at pos to runs
+ *
+ * @param runs
+ * @param pos
+ * @param c
+ */
+inline void appendRun(std::vector<PackedSequence::ExceptionRun> &runs, size_t pos, char c)
+{
+    if (!runs.empty() && runs.back().base == c &&
+        runs.back().start + runs.back().length == pos)
+        ++runs.back().length;
+    else
+        runs.push_back({pos, 1, c});
+}
+
+/**
+ * @brief Restore characters of runs in range [pos, pos + n) of str,
+ *        which is unpacked from pos.
+ *
+ * @param runs
+ * @param i     Index of first run that ends after pos
+ * @param pos
+ * @param str
+ */
+inline void restoreRuns(const std::vector<PackedSequence::ExceptionRun> &runs, size_t i,
+                        size_t pos, std::string &str)
+{
+    auto n = str.length();
+    for (; i < runs.size() && runs[i].start < pos + n; ++i)
+    {
+        auto begin = std::max(runs[i].start, pos);
+        auto end = std::min(runs[i].start + runs[i].length, pos + n);
+        std::fill(str.begin() + (begin - pos), str.begin() + (end - pos), runs[i].base);
+    }
+}
+
+/**
+ * @brief Get bitmask that has lowest bit of pair set for every 2-bit
+ *        code in bits equal to base
+ *
+ * @param bits
+ * @param base
+ * @return uint64_t
+ */
+inline uint64_t matchBase(uint64_t bits, uint8_t base)
+{
+    const uint64_t low = 0x5555555555555555ULL;
+    uint64_t x = bits ^ (low * base);
+    return ~(x | (x >> 1)) & low;
+}
+
+/**
+ * @brief Get bitmask of lowest 2n bits
+ *
+ * @param n
+ * @return uint64_t
+ */
+inline uint64_t pairMask(size_t n)
+{
+    return n >= 32 ? ~0ULL : ((1ULL << (n << 1)) - 1);
+}
+
+PackedSequence::PackedSequence()
+{
+    this->length = 0;
+    this->baseT = 'T';
+}
+
+PackedSequence::PackedSequence(const std::string &seq)
+{
+    this->length = seq.length();
+    // Code 3 is U only for RNA sequence
+    this->baseT = 'T';
+    if (seq.find('T') == std::string::npos && seq.find('U') != std::string::npos)
+        this->baseT = 'U';
+    const char otherT = this->baseT == 'T' ? 'U' : 'T';
+    this->words.assign((this->length + 31) / 32, 0);
+    for (size_t i = 0; i < this->length; ++i)
+    {
+        char c = seq[i];
+        uint8_t code = gene::codon::table.code[(uint8_t)c];
+        if (code == gene::codon::BASE_INVALID)
+        {
+            // Store as A, and record it in exception table
+            appendRun(this->exceptions, i, c);
+            continue;
+        }
+        if (c == otherT)
+            appendRun(this->otherT, i, c);
+        this->words[i >> 5] |= (uint64_t)code << (62 - ((i & 31) << 1));
+    }
+}
+
+size_t PackedSequence::size() const
+{
+    return this->length;
+}
+
+size_t PackedSequence::findRun(const std::vector<ExceptionRun> &runs, size_t pos)
+{
+    return std::partition_point(
+               runs.begin(), runs.end(),
+               [pos](const ExceptionRun &run)
+               { return run.start + run.length <= pos; }) -
+           runs.begin();
+}
+
+bool PackedSequence::hasException(size_t pos, size_t n) const
+{
+    auto i = findRun(this->exceptions, pos);
+    return i < this->exceptions.size() && this->exceptions[i].start < pos + n;
+}
+
+uint8_t PackedSequence::codon(size_t pos) const
+{
+    if (this->hasException(pos, 3))
+        return gene::codon::INVALID_CODON;
+    return (uint8_t)this->codes(pos, 3);
+}
+
+char PackedSequence::at(size_t pos) const
+{
+    auto i = findRun(this->exceptions, pos);
+    if (i < this->exceptions.size() && this->exceptions[i].start <= pos)
+        return this->exceptions[i].base;
+    i = findRun(this->otherT, pos);
+    if (i < this->otherT.size() && this->otherT[i].start <= pos)
+        return this->otherT[i].base;
+    const char bases[4] = {'A', 'C', 'G', this->baseT};
+    return bases[this->code(pos)];
+}
+
+std::string PackedSequence::unpack(size_t pos, size_t n) const
+{
+    if (pos > this->length)
+        pos = this->length;
+    if (n > this->length - pos)
+        n = this->length - pos;
+    const char bases[4] = {'A', 'C', 'G', this->baseT};
+    std::string result(n, 'A');
+    for (size_t i = 0; i < n; ++i)
+        result[i] = bases[this->code(pos + i)];
+    // Restore characters in side tables
+    restoreRuns(this->exceptions, findRun(this->exceptions, pos), pos, result);
+    restoreRuns(this->otherT, findRun(this->otherT, pos), pos, result);
+    return result;
+}
+
+size_t PackedSequence::countBase(size_t pos, size_t n, uint8_t base) const
+{
+    if (pos >= this->length)
+        return 0;
+    if (n > this->length - pos)
+        n = this->length - pos;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += 32)
+    {
+        auto m = std::min<size_t>(32, n - i);
+        count += __builtin_popcountll(matchBase(this->codes(pos + i, m), base) & pairMask(m));
+    }
+    // Exception bases are stored as A
+    if (base == gene::codon::BASE_A)
+        for (auto i = findRun(this->exceptions, pos);
+             i < this->exceptions.size() && this->exceptions[i].start < pos + n; ++i)
+        {
+            auto &run = this->exceptions[i];
+            count -= std::min(run.start + run.length, pos + n) - std::max(run.start, pos);
+        }
+    return count;
+}
+
+size_t PackedSequence::countDinucleotide(size_t pos, size_t n, uint8_t first, uint8_t second) const
+{
+    // First base must be followed by a base
+    if (pos + 1 >= this->length)
+        return 0;
+    if (n > this->length - pos - 1)
+        n = this->length - pos - 1;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += 31)
+    {
+        // Read one more base for the second base of last pair
+        auto m = std::min<size_t>(31, n - i);
+        auto bits = this->codes(pos + i, m + 1);
+        auto firstMatch = matchBase(bits, first) & pairMask(m + 1) & ~3ULL;
+        auto secondMatch = matchBase(bits, second) & pairMask(m);
+        count += __builtin_popcountll(firstMatch & (secondMatch << 2));
+    }
+    // Remove pairs that contain exception bases, which are stored as A
+    if (first == gene::codon::BASE_A || second == gene::codon::BASE_A)
+    {
+        size_t next = pos;
+        for (auto i = findRun(this->exceptions, pos == 0 ? 0 : pos - 1);
+             i < this->exceptions.size() && this->exceptions[i].start <= pos + n; ++i)
+        {
+            auto &run = this->exceptions[i];
+            auto begin = std::max(run.start == 0 ? 0 : run.start - 1, next);
+            auto end = std::min(run.start + run.length, pos + n);
+            for (auto k = begin; k < end; ++k)
+                if (this->code(k) == first && this->code(k + 1) == second)
+                    --count;
+            next = std::max(next, end);
+        }
+    }
+    return count;
+}
+
+const std::vector<uint64_t> &PackedSequence::getWords() const
+{
+    return this->words;
+}
+
+const std::vector<PackedSequence::ExceptionRun> &PackedSequence::getExceptions() const
+{
+    return this->exceptions;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#ifndef _PACKED_SEQUENCE_H
+#define _PACKED_SEQUENCE_H
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Codon.h"
+
+/**
+ * @brief 2-bit packed nucleotide sequence. 32 bases are stored in a
+ *        64-bit word, first base in the highest bits. Characters that
+ *        are not a ACGT(U) base are stored as A in the words, and kept
+ *        in a sparse side table of runs. T and U are same base (code 3),
+ *        U in DNA sequence (or T in RNA sequence) is kept in another
+ *        side table, only for unpacking.
+ */
+class PackedSequence
+{
+public:
+    /**
+     * @brief Run of same character that is not a ACGT(U) base
+     */
+    struct ExceptionRun
+    {
+        size_t start;
+        size_t length;
+        char base;
+    };
+
+private:
+    std::vector<uint64_t> words;
+    std::vector<ExceptionRun> exceptions;
+    std::vector<ExceptionRun> otherT;
+    size_t length;
+    // Character of base code 3, 'T' for DNA and 'U' for RNA
+    char baseT;
+
+    /**
+     * @brief Get index of first run that ends after pos
+     *
+     * @param runs
+     * @param pos
+     * @return size_t
+     */
+    static size_t findRun(const std::vector<ExceptionRun> &runs, size_t pos);
+
+public:
+    /**
+     * @brief Construct a empty PackedSequence object
+     */
+    PackedSequence();
+    /**
+     * @brief Pack a sequence
+     *
+     * @param seq
+     */
+    explicit PackedSequence(const std::string &seq);
+    /**
+     * @brief Get length of sequence
+     *
+     * @return size_t
+     */
+    size_t size() const;
+    /**
+     * @brief Get 2-bit code of base at pos. Bases in exception table
+     *        are code of A (0).
+     *
+     * @param pos
+     * @return uint8_t
+     */
+    inline uint8_t code(size_t pos) const
+    {
+        return (words[pos >> 5] >> (62 - ((pos & 31) << 1))) & 3;
+    }
+    /**
+     * @brief Get 2-bit codes of n (n <= 32) bases start from pos, first
+     *        base in the highest bits.
+     *
+     * @param pos
+     * @param n
+     * @return uint64_t
+     */
+    inline uint64_t codes(size_t pos, size_t n) const
+    {
+        auto shift = (pos & 31) << 1;
+        uint64_t bits = words[pos >> 5] << shift;
+        if (shift != 0 && (pos >> 5) + 1 < words.size())
+            bits |= words[(pos >> 5) + 1] >> (64 - shift);
+        return bits >> (64 - (n << 1));
+    }
+    /**
+     * @brief Check if range [pos, pos + n) contains a base in exception
+     *        table.
+     *
+     * @param pos
+     * @param n
+     * @return true
+     * @return false
+     */
+    bool hasException(size_t pos, size_t n) const;
+    /**
+     * @brief Get codon code of forward strand at pos,
+     *        gene::codon::INVALID_CODON if it contains invalid base.
+     *
+     * @param pos
+     * @return uint8_t
+     */
+    uint8_t codon(size_t pos) const;
+    /**
+     * @brief Get character at pos
+     *
+     * @param pos
+     * @return char
+     */
+    char at(size_t pos) const;
+    /**
+     * @brief Unpack a part of sequence
+     *
+     * @param pos
+     * @param n
+     * @return std::string
+     */
+    std::string unpack(size_t pos = 0, size_t n = std::string::npos) const;
+    /**
+     * @brief Count base code in range [pos, pos + n)
+     *
+     * @param pos
+     * @param n
+     * @param base  2-bit code of base
+     * @return size_t
+     */
+    size_t countBase(size_t pos, size_t n, uint8_t base) const;
+    /**
+     * @brief Count dinucleotide (first base followed by second base),
+     *        that first base is in range [pos, pos + n)
+     *
+     * @param pos
+     * @param n
+     * @param first     2-bit code of first base
+     * @param second    2-bit code of second base
+     * @return size_t
+     */
+    size_t countDinucleotide(size_t pos, size_t n, uint8_t first, uint8_t second) const;
+    /**
+     * @brief Get packed words
+     *
+     * @return const std::vector<uint64_t>&
+     */
+    const std::vector<uint64_t> &getWords() const;
+    /**
+     * @brief Get exception runs, sorted by position
+     *
+     * @return const std::vector<ExceptionRun>&
+     */
+    const std::vector<ExceptionRun> &getExceptions() const;
+};
+#endif
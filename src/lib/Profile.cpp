@@ -0,0 +1,171 @@
+#include "Profile.h"
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <string>
+#include <time.h>
+
+#ifdef _WIN32
+#define CLOCK_THREAD_CPUTIME_ID 0
+#define CLOCK_PROCESS_CPUTIME_ID 0
+#endif
+
+std::atomic<bool> gene::profile::active(false);
+std::atomic<uint64_t> gene::profile::counters[gene::profile::COUNTER_COUNT];
+
+// Time of phases in nanoseconds, and number of scopes
+static std::atomic<int64_t> wallTime[gene::profile::PHASE_COUNT];
+static std::atomic<int64_t> cpuTime[gene::profile::PHASE_COUNT];
+static std::atomic<uint64_t> calls[gene::profile::PHASE_COUNT];
+static int64_t enabledWall = 0;
+static int64_t enabledCpu = 0;
+// Innermost open scope of thread
+static thread_local gene::profile::Scope *current = nullptr;
+
+static const char *PHASE_NAMES[gene::profile::PHASE_COUNT] = {
+    "read", "strand", "scan", "prepare", "judge", "balance", "format", "write"};
+static const char *COUNTER_NAMES[gene::profile::COUNTER_COUNT] = {
+    "bases_read", "bytes_read", "orfs_found", "orfs_elided", "orfs_judged", "genes", "bytes_written", "messages_sent", "bytes_sent"};
+
+/**
+ * @brief Get monotonic wall clock in nanoseconds
+ *
+ * @return int64_t
+ */
+inline int64_t wallNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Get CPU time of a clock in nanoseconds, wall clock if the
+ *        platform has no such clock
+ *
+ * @param clock     CLOCK_THREAD_CPUTIME_ID or CLOCK_PROCESS_CPUTIME_ID
+ * @return int64_t
+ */
+inline int64_t cpuNow(int clock)
+{
+#ifdef _WIN32
+    return wallNow();
+#else
+    timespec t;
+    clock_gettime(clock, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+#endif
+}
+
+void gene::profile::enable()
+{
+    for (int i = 0; i < PHASE_COUNT; ++i)
+    {
+        wallTime[i] = 0;
+        cpuTime[i] = 0;
+        calls[i] = 0;
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+        counters[i] = 0;
+    enabledWall = wallNow();
+    enabledCpu = cpuNow(CLOCK_PROCESS_CPUTIME_ID);
+    active = true;
+}
+
+void gene::profile::Scope::start()
+{
+    this->parent = current;
+    current = this;
+    this->innerWall = this->innerCpu = 0;
+    this->wall = wallNow();
+    this->cpu = cpuNow(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void gene::profile::Scope::stop()
+{
+    int64_t wall = wallNow() - this->wall;
+    int64_t cpu = cpuNow(CLOCK_THREAD_CPUTIME_ID) - this->cpu;
+    // Time of inner scopes is counted by their phases
+    wallTime[this->phase].fetch_add(wall - this->innerWall, std::memory_order_relaxed);
+    cpuTime[this->phase].fetch_add(cpu - this->innerCpu, std::memory_order_relaxed);
+    calls[this->phase].fetch_add(1, std::memory_order_relaxed);
+    if (this->parent != nullptr)
+    {
+        this->parent->innerWall += wall;
+        this->parent->innerCpu += cpu;
+    }
+    current = this->parent;
+}
+
+gene::profile::Snapshot gene::profile::snapshot()
+{
+    Snapshot result;
+    for (int i = 0; i < PHASE_COUNT; ++i)
+    {
+        result.wall[i] = wallTime[i] / 1e9;
+        result.cpu[i] = cpuTime[i] / 1e9;
+        result.calls[i] = calls[i];
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+        result.counters[i] = counters[i];
+    result.elapsed = (wallNow() - enabledWall) / 1e9;
+    result.processCpu = (cpuNow(CLOCK_PROCESS_CPUTIME_ID) - enabledCpu) / 1e9;
+    return result;
+}
+
+/**
+ * @brief Write a snapshot as a JSON object
+ *
+ * @param out
+ * @param s
+ * @param indent
+ */
+static void writeSnapshot(std::ostream &out, const gene::profile::Snapshot &s, const std::string &indent)
+{
+    using namespace gene::profile;
+    out << "{\n"
+        << indent << "  \"elapsed\": " << s.elapsed << ",\n"
+        << indent << "  \"cpu\": " << s.processCpu << ",\n"
+        << indent << "  \"phases\": {\n";
+    for (int i = 0; i < PHASE_COUNT; ++i)
+        out << indent << "    \"" << PHASE_NAMES[i] << "\": {\"wall\": " << s.wall[i]
+            << ", \"cpu\": " << s.cpu[i] << ", \"calls\": " << (uint64_t)s.calls[i] << "}"
+            << (i + 1 < PHASE_COUNT ? ",\n" : "\n");
+    out << indent << "  },\n"
+        << indent << "  \"counters\": {\n";
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+        out << indent << "    \"" << COUNTER_NAMES[i] << "\": " << (uint64_t)s.counters[i]
+            << (i + 1 < COUNTER_COUNT ? ",\n" : "\n");
+    out << indent << "  }\n"
+        << indent << "}";
+}
+
+void gene::profile::writeJson(std::ostream &out, const std::vector<Snapshot> &ranks)
+{
+    Snapshot total{};
+    for (auto &s : ranks)
+    {
+        for (int i = 0; i < PHASE_COUNT; ++i)
+        {
+            total.wall[i] += s.wall[i];
+            total.cpu[i] += s.cpu[i];
+            total.calls[i] += s.calls[i];
+        }
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+            total.counters[i] += s.counters[i];
+        total.elapsed = std::max(total.elapsed, s.elapsed);
+        total.processCpu += s.processCpu;
+    }
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(6);
+    out << "{\n  \"ranks\": [\n";
+    for (size_t r = 0; r < ranks.size(); ++r)
+    {
+        out << "    ";
+        writeSnapshot(out, ranks[r], "    ");
+        out << (r + 1 < ranks.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n  \"total\": ";
+    writeSnapshot(out, total, "  ");
+    out << "\n}\n";
+    out.flags(flags);
+}
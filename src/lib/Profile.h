@@ -0,0 +1,157 @@
+#pragma once
+#ifndef _PROFILE_H
+#define _PROFILE_H
+#include <atomic>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+namespace gene
+{
+    /**
+     * @brief Lightweight instrumentation of hot paths. Scopes add their
+     *        wall and CPU time to a phase, and counters count items. Both
+     *        are process wide atomics. When profiling is off, a scope or
+     *        a counter costs one relaxed load and a branch.
+     *
+     *        Scopes are opened by the thread doing the work, inside
+     *        parallel loops, so wall time of a phase is the busy time of
+     *        all threads in it, and CPU time is their thread CPU time.
+     *        Phases are exclusive: time of a scope opened inside another
+     *        scope of the thread counts only to the inner phase, so the
+     *        phases of a thread add up to at most its busy time.
+     */
+    namespace profile
+    {
+        enum Phase
+        {
+            // Reading and parsing sequences
+            Read,
+            // Copy and complement of strand by forward scanner
+            Strand,
+            // Finding ORFs
+            Scan,
+            // Preparing judge context of sequence
+            Prepare,
+            // isGene
+            Judge,
+            // Moving ORFs between MPI processes, without judging
+            Balance,
+            // Formatting genes
+            Format,
+            // Writing output
+            Write,
+            PHASE_COUNT
+        };
+
+        enum Counter
+        {
+            // Bases of sequences read, without line breaks and labels
+            BasesRead,
+            // Bytes of input consumed, with line breaks and labels
+            BytesRead,
+            OrfsFound,
+            // ORFs removed by keepLongestORFS before judging
+            OrfsElided,
+            OrfsJudged,
+            Genes,
+            BytesWritten,
+            MessagesSent,
+            BytesSent,
+            COUNTER_COUNT
+        };
+
+        /**
+         * @brief Profile of a process, plain doubles, so snapshots of all
+         *        MPI processes can be gathered as MPI_DOUBLE arrays.
+         */
+        struct Snapshot
+        {
+            double wall[PHASE_COUNT];
+            double cpu[PHASE_COUNT];
+            double calls[PHASE_COUNT];
+            double counters[COUNTER_COUNT];
+            // Wall and CPU time of process since enable()
+            double elapsed;
+            double processCpu;
+        };
+
+        extern std::atomic<bool> active;
+        extern std::atomic<uint64_t> counters[COUNTER_COUNT];
+
+        /**
+         * @brief Start profiling, reset all phases and counters
+         */
+        void enable();
+        /**
+         * @brief Check if profiling is on
+         *
+         * @return true
+         * @return false
+         */
+        inline bool isEnabled()
+        {
+            return active.load(std::memory_order_relaxed);
+        }
+        /**
+         * @brief Add n to a counter
+         *
+         * @param counter
+         * @param n
+         */
+        inline void count(Counter counter, uint64_t n)
+        {
+            if (isEnabled())
+                counters[counter].fetch_add(n, std::memory_order_relaxed);
+        }
+        /**
+         * @brief Take a snapshot of phases and counters of process
+         *
+         * @return Snapshot
+         */
+        Snapshot snapshot();
+        /**
+         * @brief Write snapshots of processes as JSON: every process by
+         *        rank, and total of all processes. Elapsed time of total
+         *        is the maximum of processes.
+         *
+         * @param out
+         * @param ranks
+         */
+        void writeJson(std::ostream &out, const std::vector<Snapshot> &ranks);
+
+        /**
+         * @brief A timed scope of a phase
+         */
+        class Scope
+        {
+        private:
+            Phase phase;
+            bool timed;
+            int64_t wall;
+            int64_t cpu;
+            // Enclosing scope of thread, and time of scopes inside this one
+            Scope *parent;
+            int64_t innerWall;
+            int64_t innerCpu;
+
+            void start();
+            void stop();
+
+        public:
+            explicit Scope(Phase phase) : phase(phase), timed(isEnabled())
+            {
+                if (this->timed)
+                    this->start();
+            }
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+            ~Scope()
+            {
+                if (this->timed)
+                    this->stop();
+            }
+        };
+    }
+}
+#endif
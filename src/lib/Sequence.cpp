@@ -1,14 +1,37 @@
 #include "Sequence.h"
+#include "PackedSequence.h"
+#include <atomic>
+
+/**
+ * @brief Get a new sequence identifier
+ *
+ * @return uint64_t
+ */
+static uint64_t nextId()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
 
 Sequence::Sequence(const std::string &label, const std::string &seq)
 {
     this->label = label;
     this->sequence = seq;
+    this->id = nextId();
+    this->error = false;
+}
+
+Sequence::Sequence(const std::string &label, std::string &&seq)
+{
+    this->label = label;
+    this->sequence = std::move(seq);
+    this->id = nextId();
     this->error = false;
 }
 
 Sequence::Sequence(bool error)
 {
+    this->id = nextId();
     this->error = error;
 }
 
@@ -30,6 +53,32 @@ void Sequence::setLabel(const std::string &label)
 void Sequence::setSequence(const std::string &seq)
 {
     this->sequence = seq;
+    this->packed.reset();
+    this->id = nextId();
+}
+
+std::string Sequence::takeSequence()
+{
+    this->packed.reset();
+    this->id = nextId();
+    std::string data;
+    data.swap(this->sequence);
+    return data;
+}
+
+void Sequence::pack()
+{
+    this->packed = std::make_shared<const PackedSequence>(this->sequence);
+}
+
+const PackedSequence *Sequence::getPacked() const
+{
+    return this->packed.get();
+}
+
+uint64_t Sequence::getId() const
+{
+    return this->id;
 }
 
 Sequence::operator bool() const
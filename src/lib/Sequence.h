@@ -2,6 +2,11 @@
 #ifndef _SEQUENCE_H
 #define _SEQUENCE_H
 #include <string>
+#include <memory>
+#include <stdint.h>
+
+class PackedSequence;
+
 /**
  * @brief A fasta sequence object, contains a label and sequence.
  */
@@ -10,6 +15,8 @@ class Sequence
 private:
     std::string label;
     std::string sequence;
+    std::shared_ptr<const PackedSequence> packed;
+    uint64_t id;
     bool error;
 
 public:
@@ -20,6 +27,14 @@ public:
      * @param seq
      */
     Sequence(const std::string &label, const std::string &seq);
+    /**
+     * @brief Construct a new Sequence object, take the sequence
+     *        data without copy.
+     *
+     * @param label
+     * @param seq
+     */
+    Sequence(const std::string &label, std::string &&seq);
     /**
      * @brief Construct a new Sequence object, which contains
      *        a validation flag.
@@ -51,6 +66,36 @@ public:
      * @param seq
      */
     void setSequence(const std::string &seq);
+    /**
+     * @brief Move the sequence data out of the object, it is left with
+     *        an empty sequence. Owners can append to the data without
+     *        copy, and construct a new Sequence of it.
+     *
+     * @return std::string
+     */
+    std::string takeSequence();
+    /**
+     * @brief Build 2-bit packed representation of the sequence, which
+     *        is used by getORFS and can be used by isGene. It is kept
+     *        next to the characters, so it adds a quarter of the length
+     *        in bytes to the memory of sequence.
+     */
+    void pack();
+    /**
+     * @brief Get the packed representation of the sequence
+     *
+     * @return const PackedSequence*   nullptr, if sequence is not packed.
+     */
+    const PackedSequence *getPacked() const;
+    /**
+     * @brief Get the identifier of sequence content. Every constructed
+     *        sequence and every setSequence() gets a new identifier,
+     *        copies of a sequence share the identifier. It can be used
+     *        as the key of per-sequence caches.
+     *
+     * @return uint64_t
+     */
+    uint64_t getId() const;
     /**
      * @brief Check if the sequence object is valid.
      *
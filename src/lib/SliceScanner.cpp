@@ -0,0 +1,155 @@
+#include "SliceScanner.h"
+#include "Codon.h"
+#include <algorithm>
+
+// Bases read beyond context at first, they are doubled when region grows
+const size_t MIN_MARGIN = 192;
+
+/**
+ * @brief Get 6-bit code of codon at position o, INVALID_CODON if it
+ *        contains non ACGTU base.
+ *
+ * @param data
+ * @param o
+ * @return uint8_t
+ */
+inline uint8_t codonAt(const std::string &data, size_t o)
+{
+    const auto &table = gene::codon::table;
+    uint8_t a = table.code[(uint8_t)data[o]];
+    uint8_t b = table.code[(uint8_t)data[o + 1]];
+    uint8_t c = table.code[(uint8_t)data[o + 2]];
+    return (a | b | c) & gene::codon::BASE_INVALID
+               ? gene::codon::INVALID_CODON
+               : a << 4 | b << 2 | c;
+}
+
+gene::SliceScanner::SliceScanner(size_t length, size_t start, size_t end, size_t context,
+                                 ScanMode mode, bool packed, bool longest)
+    : length(length), start(std::min(start, length)), end(std::min(end, length)),
+      context(context), mode(mode), packed(packed), longest(longest),
+      headMargin(std::max(context, MIN_MARGIN)), tailMargin(std::max(context, MIN_MARGIN)),
+      window("", "")
+{
+    this->regionStart = this->start > this->context + this->headMargin
+                            ? (this->start - this->context - this->headMargin) / 3 * 3
+                            : 0;
+    size_t regionEnd = this->end + this->context + this->tailMargin;
+    // (length - regionEnd) % 3 == 0
+    this->regionEnd = regionEnd >= length ? length : regionEnd + (length - regionEnd) % 3;
+}
+
+size_t gene::SliceScanner::getRegionStart() const
+{
+    return this->regionStart;
+}
+
+size_t gene::SliceScanner::getRegionEnd() const
+{
+    return this->regionEnd;
+}
+
+bool gene::SliceScanner::push(Sequence &&region)
+{
+    this->window = std::move(region);
+    if (this->packed)
+        this->window.pack();
+    const auto &data = this->window.getSequence();
+    const size_t offset = this->regionStart, l = data.length();
+    bool complete = true;
+    // Forward ORFs of slice end at the first stop codon of their frame
+    // after slice, it must be seen by getORFS on window with context.
+    // A longer reverse ORF of same stop codon starts after a reverse ORF
+    // of slice, and before the first reverse stop codon of their frame.
+    if (this->regionEnd < this->length)
+    {
+        bool phase[3] = {false, false, false};
+        int found = 0;
+        for (size_t o = this->end - offset; found < 3 && o + 4 + this->context <= l; ++o)
+            if (!phase[o % 3] && gene::codon::isStop(codonAt(data, o)))
+            {
+                phase[o % 3] = true;
+                ++found;
+            }
+        bool reverse[3] = {false, false, false};
+        int reverseFound = this->longest ? 0 : 3;
+        for (size_t o = this->end - offset; reverseFound < 3 && o + 3 <= l; ++o)
+        {
+            auto codon = codonAt(data, o);
+            if (!reverse[o % 3] && codon != gene::codon::INVALID_CODON &&
+                gene::codon::isStop(gene::codon::table.reverseComplement[codon]))
+            {
+                reverse[o % 3] = true;
+                ++reverseFound;
+            }
+        }
+        if (found < 3 || reverseFound < 3)
+        {
+            complete = false;
+            this->tailMargin *= 2;
+            size_t regionEnd = this->end + this->context + this->tailMargin;
+            this->regionEnd = regionEnd >= this->length
+                                  ? this->length
+                                  : regionEnd + (this->length - regionEnd) % 3;
+        }
+    }
+    // Reverse ORFs of slice end at the last reverse stop codon of their
+    // frame before their start codon. A longer forward ORF of same stop
+    // codon starts after the last stop codon of their frame before slice.
+    if (this->regionStart > 0)
+    {
+        bool phase[3] = {false, false, false};
+        int found = 0;
+        for (int64_t o = (int64_t)(this->start - offset) - 5;
+             found < 3 && o >= (int64_t)this->context + 1; --o)
+        {
+            auto codon = codonAt(data, o);
+            if (!phase[o % 3] && codon != gene::codon::INVALID_CODON &&
+                gene::codon::isStop(gene::codon::table.reverseComplement[codon]))
+            {
+                phase[o % 3] = true;
+                ++found;
+            }
+        }
+        bool forward[3] = {false, false, false};
+        int forwardFound = this->longest ? 0 : 3;
+        for (int64_t o = (int64_t)(this->start - offset) - 1; forwardFound < 3 && o >= 0; --o)
+            if (!forward[o % 3] && gene::codon::isStop(codonAt(data, o)))
+            {
+                forward[o % 3] = true;
+                ++forwardFound;
+            }
+        if (found < 3 || forwardFound < 3)
+        {
+            complete = false;
+            this->headMargin *= 2;
+            this->regionStart = this->start > this->context + this->headMargin
+                                    ? (this->start - this->context - this->headMargin) / 3 * 3
+                                    : 0;
+        }
+    }
+    return complete;
+}
+
+std::vector<gene::GeneRange> gene::SliceScanner::getORFS(int8_t frame) const
+{
+    std::vector<GeneRange> result;
+    if (this->start >= this->end)
+        return result;
+    const size_t offset = this->regionStart;
+    for (auto &orf : gene::getORFS(this->window, frame, 0,
+                                   this->window.getSequence().length(), this->mode))
+        if (orf.start + offset >= this->start && orf.start + offset < this->end)
+            result.push_back(orf);
+    return result;
+}
+
+const Sequence &gene::SliceScanner::getWindow() const
+{
+    return this->window;
+}
+
+size_t gene::SliceScanner::getOffset() const
+{
+    return this->regionStart;
+}
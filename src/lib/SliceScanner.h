@@ -0,0 +1,106 @@
+#pragma once
+#ifndef _SLICE_SCANNER_H
+#define _SLICE_SCANNER_H
+#include <vector>
+#include <string>
+#include "Sequence.h"
+#include "GeneRange.h"
+#include "orf_finder.h"
+
+namespace gene
+{
+    /**
+     * @brief Scan ORFs of a slice of a record: the ORFs whose start
+     *        codon (GeneRange::start) is in [start, end) of the record.
+     *        Only a region of record around the slice is needed. The
+     *        region grows until every ORF of the slice ends in it with
+     *        context bases on both sides (or at the border of record),
+     *        so ORFs and gene judge are same as on the whole record.
+     *
+     *        Slices of [0, length) split by any positions return every
+     *        ORF of the record exactly once, so MPI processes can each
+     *        read and scan their own slice. With longest, the region
+     *        also reaches a stop codon of every frame before the slice,
+     *        so keepLongestORFS on window finds longer ORFs of the same
+     *        stop codon that start in an earlier slice.
+     */
+    class SliceScanner
+    {
+    private:
+        size_t length;
+        size_t start;
+        size_t end;
+        size_t context;
+        ScanMode mode;
+        bool packed;
+        bool longest;
+        // Region of record to read
+        size_t regionStart;
+        size_t regionEnd;
+        // Bases read before region on each side
+        size_t headMargin;
+        size_t tailMargin;
+        Sequence window;
+
+    public:
+        /**
+         * @brief Construct a new Slice Scanner object
+         *
+         * @param length    Length of record
+         * @param start     Start of slice
+         * @param end       End of slice (exclusive)
+         * @param context   Bases kept around ORF for gene judge
+         * @param mode      Scanning engine
+         * @param packed    Use 2-bit packed representation of window
+         * @param longest   Window is used by keepLongestORFS
+         */
+        SliceScanner(size_t length, size_t start, size_t end, size_t context,
+                     ScanMode mode = ScanMode::Linear, bool packed = false, bool longest = false);
+        /**
+         * @brief Get start of region of record to read. It is a multiple
+         *        of 3, so forward frames of window match the record.
+         *
+         * @return size_t
+         */
+        size_t getRegionStart() const;
+        /**
+         * @brief Get end of region of record to read (exclusive). It is
+         *        in same phase as record end, so reverse frames of window
+         *        match the record.
+         *
+         * @return size_t
+         */
+        size_t getRegionEnd() const;
+        /**
+         * @brief Set window to bases [getRegionStart(), getRegionEnd())
+         *        of record, window takes the label of region.
+         *
+         * @param region
+         * @return true     Window covers every ORF of slice.
+         * @return false    Some ORF may end outside of window, region is
+         *                  grown. Read it and push again.
+         */
+        bool push(Sequence &&region);
+        /**
+         * @brief Get ORFs of a frame that start in slice, in window
+         *        coordinates.
+         *
+         * @param frame
+         * @return std::vector<GeneRange>
+         */
+        std::vector<GeneRange> getORFS(int8_t frame) const;
+        /**
+         * @brief Get current window
+         *
+         * @return const Sequence&
+         */
+        const Sequence &getWindow() const;
+        /**
+         * @brief Get position of window in record
+         *
+         * @return size_t
+         */
+        size_t getOffset() const;
+    };
+}
+#endif
@@ -0,0 +1,114 @@
+#include "TaskScheduler.h"
+#include <omp.h>
+
+// Scheduler and worker of current thread, for tasks submitted by tasks
+static thread_local const gene::TaskScheduler *currentScheduler = nullptr;
+static thread_local size_t currentWorker = 0;
+
+gene::TaskScheduler::TaskScheduler(size_t threads)
+    : queued(0), pending(0), next(0), stop(false)
+{
+    if (threads == 0)
+        threads = omp_get_max_threads();
+    for (size_t i = 0; i < threads; ++i)
+        this->workers.emplace_back(new Worker());
+    for (size_t i = 0; i < threads; ++i)
+        this->threads.emplace_back(&TaskScheduler::run, this, i);
+}
+
+gene::TaskScheduler::~TaskScheduler()
+{
+    this->wait();
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stop = true;
+    }
+    this->wake.notify_all();
+    for (auto &thread : this->threads)
+        thread.join();
+}
+
+void gene::TaskScheduler::submit(Task task)
+{
+    size_t id = currentScheduler == this
+                    ? currentWorker
+                    : this->next.fetch_add(1) % this->workers.size();
+    this->pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(this->workers[id]->lock);
+        this->workers[id]->tasks.push_back(std::move(task));
+    }
+    this->queued.fetch_add(1);
+    // Take the lock, so a worker can not miss the wake up between its
+    // check of queued and its wait
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+    }
+    this->wake.notify_one();
+}
+
+void gene::TaskScheduler::wait()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->idle.wait(guard, [this]()
+                    { return this->pending.load() == 0; });
+}
+
+size_t gene::TaskScheduler::size() const
+{
+    return this->workers.size();
+}
+
+bool gene::TaskScheduler::take(size_t id, Task &task)
+{
+    const size_t n = this->workers.size();
+    for (size_t k = 0; k < n; ++k)
+    {
+        auto &worker = *this->workers[(id + k) % n];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.tasks.empty())
+            continue;
+        // Own deque is used as a stack, others as a queue
+        if (k == 0)
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        this->queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void gene::TaskScheduler::run(size_t id)
+{
+    currentScheduler = this;
+    currentWorker = id;
+    // Parallelism comes from tasks, not from nested OpenMP regions
+    omp_set_num_threads(1);
+    Task task;
+    for (;;)
+    {
+        if (this->take(id, task))
+        {
+            task();
+            task = nullptr;
+            if (this->pending.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> guard(this->lock);
+                this->idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->wake.wait(guard, [this]()
+                        { return this->stop || this->queued.load() != 0; });
+        if (this->stop && this->queued.load() == 0)
+            return;
+    }
+}
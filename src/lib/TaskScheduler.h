@@ -0,0 +1,99 @@
+#pragma once
+#ifndef _TASK_SCHEDULER_H
+#define _TASK_SCHEDULER_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace gene
+{
+    /**
+     * @brief A task scheduler with work stealing deques. Every worker
+     *        thread owns a deque: tasks submitted from a task are pushed
+     *        to the back of deque of its worker and popped from the back,
+     *        so they run on the same worker first. Idle workers steal from
+     *        the front of other deques, which holds the oldest tasks.
+     *
+     *        Workers run OpenMP regions with one thread, so parallel loops
+     *        called by tasks do not oversubscribe cores.
+     */
+    class TaskScheduler
+    {
+    public:
+        using Task = std::function<void()>;
+
+    private:
+        struct Worker
+        {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        // Sleeping workers and wait() are woken up by this lock
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        // Tasks in deques, and tasks submitted but not finished
+        std::atomic<size_t> queued;
+        std::atomic<size_t> pending;
+        // Deque for tasks submitted outside of workers
+        std::atomic<size_t> next;
+        bool stop;
+
+        /**
+         * @brief Main loop of worker thread
+         *
+         * @param id
+         */
+        void run(size_t id);
+        /**
+         * @brief Pop a task from back of own deque, or steal one from
+         *        front of other deques
+         *
+         * @param id
+         * @param task
+         * @return true     Got a task.
+         * @return false    All deques are empty.
+         */
+        bool take(size_t id, Task &task);
+
+    public:
+        /**
+         * @brief Start worker threads
+         *
+         * @param threads   Number of workers, 0 for omp_get_max_threads()
+         */
+        explicit TaskScheduler(size_t threads = 0);
+        TaskScheduler(const TaskScheduler &) = delete;
+        TaskScheduler &operator=(const TaskScheduler &) = delete;
+        /**
+         * @brief Wait for all tasks and stop worker threads
+         */
+        ~TaskScheduler();
+        /**
+         * @brief Submit a task. It can be called from tasks, and from
+         *        other threads.
+         *
+         * @param task
+         */
+        void submit(Task task);
+        /**
+         * @brief Wait until all submitted tasks, and tasks they submit,
+         *        are finished. It must not be called from tasks.
+         */
+        void wait();
+        /**
+         * @brief Get number of workers
+         *
+         * @return size_t
+         */
+        size_t size() const;
+    };
+}
+#endif
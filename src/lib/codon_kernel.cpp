@@ -0,0 +1,224 @@
+#include "codon_kernel.h"
+#include "Codon.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CODON_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// Class bits of codon code
+const uint8_t CLASS_START = 1;
+const uint8_t CLASS_STOP = 2;
+const uint8_t CLASS_REVERSE_START = 4;
+const uint8_t CLASS_REVERSE_STOP = 8;
+
+/**
+ * @brief Class bits of every codon code, INVALID_CODON has no class
+ */
+static const struct CodonClassTable
+{
+    uint8_t value[gene::codon::INVALID_CODON + 1];
+    CodonClassTable()
+    {
+        for (int c = 0; c <= gene::codon::INVALID_CODON; ++c)
+        {
+            value[c] = 0;
+            if (c == gene::codon::INVALID_CODON)
+                continue;
+            auto r = gene::codon::table.reverseComplement[c];
+            if (gene::codon::isStart(c))
+                value[c] |= CLASS_START;
+            if (gene::codon::isStop(c))
+                value[c] |= CLASS_STOP;
+            if (gene::codon::isStart(r))
+                value[c] |= CLASS_REVERSE_START;
+            if (gene::codon::isStop(r))
+                value[c] |= CLASS_REVERSE_STOP;
+        }
+    }
+} codonClass;
+
+/**
+ * @brief Set bits of count positions start from first of block by
+ *        table lookup
+ *
+ * @param data
+ * @param first     First position of block
+ * @param count
+ * @param masks
+ */
+inline void scalarBlock(const char *data, size_t first, size_t count, gene::codon::CodonMasks &masks)
+{
+    const auto &code = gene::codon::table.code;
+    masks = {0, 0, 0, 0};
+    for (size_t k = 0; k < count; ++k)
+    {
+        const char *p = data + first + k;
+        uint8_t b0 = code[(uint8_t)p[0]], b1 = code[(uint8_t)p[1]], b2 = code[(uint8_t)p[2]];
+        if ((b0 | b1 | b2) & gene::codon::BASE_INVALID)
+            continue;
+        auto c = codonClass.value[(b0 << 4) | (b1 << 2) | b2];
+        masks.start |= (uint64_t)((c & CLASS_START) != 0) << k;
+        masks.stop |= (uint64_t)((c & CLASS_STOP) != 0) << k;
+        masks.reverseStart |= (uint64_t)((c & CLASS_REVERSE_START) != 0) << k;
+        masks.reverseStop |= (uint64_t)((c & CLASS_REVERSE_STOP) != 0) << k;
+    }
+}
+
+/**
+ * @brief Scalar kernel
+ *
+ * @param data
+ * @param n
+ * @param masks
+ */
+static void scanScalar(const char *data, size_t n, gene::codon::CodonMasks *masks)
+{
+    for (size_t b = 0; b * 64 < n; ++b)
+        scalarBlock(data, b * 64, n - b * 64 < 64 ? n - b * 64 : 64, masks[b]);
+}
+
+#ifdef CODON_KERNEL_X86
+/**
+ * @brief SSE4.2 kernel, 16 positions per step
+ *
+ * @param data
+ * @param n
+ * @param masks
+ */
+__attribute__((target("sse4.2"))) static void scanSse42(const char *data, size_t n, gene::codon::CodonMasks *masks)
+{
+    const __m128i a = _mm_set1_epi8('A'), c = _mm_set1_epi8('C'), g = _mm_set1_epi8('G');
+    const __m128i t = _mm_set1_epi8('T'), u = _mm_set1_epi8('U');
+    size_t b = 0;
+    for (; b * 64 + 64 <= n; ++b)
+    {
+        auto &m = masks[b];
+        m = {0, 0, 0, 0};
+        for (int h = 0; h < 4; ++h)
+        {
+            const char *p = data + b * 64 + h * 16;
+            __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+            __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 1));
+            __m128i v2 = _mm_loadu_si128((const __m128i *)(p + 2));
+            __m128i a0 = _mm_cmpeq_epi8(v0, a), a1 = _mm_cmpeq_epi8(v1, a), a2 = _mm_cmpeq_epi8(v2, a);
+            __m128i c0 = _mm_cmpeq_epi8(v0, c), c1 = _mm_cmpeq_epi8(v1, c);
+            __m128i g1 = _mm_cmpeq_epi8(v1, g), g2 = _mm_cmpeq_epi8(v2, g);
+            __m128i t0 = _mm_or_si128(_mm_cmpeq_epi8(v0, t), _mm_cmpeq_epi8(v0, u));
+            __m128i t1 = _mm_or_si128(_mm_cmpeq_epi8(v1, t), _mm_cmpeq_epi8(v1, u));
+            __m128i t2 = _mm_or_si128(_mm_cmpeq_epi8(v2, t), _mm_cmpeq_epi8(v2, u));
+            // AUG
+            __m128i start = _mm_and_si128(a0, _mm_and_si128(t1, g2));
+            // UAA, UAG, UGA
+            __m128i stop = _mm_and_si128(t0, _mm_or_si128(
+                                                 _mm_and_si128(a1, _mm_or_si128(a2, g2)),
+                                                 _mm_and_si128(g1, a2)));
+            // CAU
+            __m128i rstart = _mm_and_si128(c0, _mm_and_si128(a1, t2));
+            // UUA, CUA, UCA
+            __m128i rstop = _mm_and_si128(a2, _mm_or_si128(
+                                                  _mm_and_si128(_mm_or_si128(t0, c0), t1),
+                                                  _mm_and_si128(t0, c1)));
+            auto shift = h * 16;
+            m.start |= (uint64_t)(uint16_t)_mm_movemask_epi8(start) << shift;
+            m.stop |= (uint64_t)(uint16_t)_mm_movemask_epi8(stop) << shift;
+            m.reverseStart |= (uint64_t)(uint16_t)_mm_movemask_epi8(rstart) << shift;
+            m.reverseStop |= (uint64_t)(uint16_t)_mm_movemask_epi8(rstop) << shift;
+        }
+    }
+    if (b * 64 < n)
+        scalarBlock(data, b * 64, n - b * 64, masks[b]);
+}
+
+/**
+ * @brief AVX2 kernel, 32 positions per step
+ *
+ * @param data
+ * @param n
+ * @param masks
+ */
+__attribute__((target("avx2"))) static void scanAvx2(const char *data, size_t n, gene::codon::CodonMasks *masks)
+{
+    const __m256i a = _mm256_set1_epi8('A'), c = _mm256_set1_epi8('C'), g = _mm256_set1_epi8('G');
+    const __m256i t = _mm256_set1_epi8('T'), u = _mm256_set1_epi8('U');
+    size_t b = 0;
+    for (; b * 64 + 64 <= n; ++b)
+    {
+        auto &m = masks[b];
+        m = {0, 0, 0, 0};
+        for (int h = 0; h < 2; ++h)
+        {
+            const char *p = data + b * 64 + h * 32;
+            __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+            __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+            __m256i v2 = _mm256_loadu_si256((const __m256i *)(p + 2));
+            __m256i a0 = _mm256_cmpeq_epi8(v0, a), a1 = _mm256_cmpeq_epi8(v1, a), a2 = _mm256_cmpeq_epi8(v2, a);
+            __m256i c0 = _mm256_cmpeq_epi8(v0, c), c1 = _mm256_cmpeq_epi8(v1, c);
+            __m256i g1 = _mm256_cmpeq_epi8(v1, g), g2 = _mm256_cmpeq_epi8(v2, g);
+            __m256i t0 = _mm256_or_si256(_mm256_cmpeq_epi8(v0, t), _mm256_cmpeq_epi8(v0, u));
+            __m256i t1 = _mm256_or_si256(_mm256_cmpeq_epi8(v1, t), _mm256_cmpeq_epi8(v1, u));
+            __m256i t2 = _mm256_or_si256(_mm256_cmpeq_epi8(v2, t), _mm256_cmpeq_epi8(v2, u));
+            // AUG
+            __m256i start = _mm256_and_si256(a0, _mm256_and_si256(t1, g2));
+            // UAA, UAG, UGA
+            __m256i stop = _mm256_and_si256(t0, _mm256_or_si256(
+                                                    _mm256_and_si256(a1, _mm256_or_si256(a2, g2)),
+                                                    _mm256_and_si256(g1, a2)));
+            // CAU
+            __m256i rstart = _mm256_and_si256(c0, _mm256_and_si256(a1, t2));
+            // UUA, CUA, UCA
+            __m256i rstop = _mm256_and_si256(a2, _mm256_or_si256(
+                                                     _mm256_and_si256(_mm256_or_si256(t0, c0), t1),
+                                                     _mm256_and_si256(t0, c1)));
+            auto shift = h * 32;
+            m.start |= (uint64_t)(uint32_t)_mm256_movemask_epi8(start) << shift;
+            m.stop |= (uint64_t)(uint32_t)_mm256_movemask_epi8(stop) << shift;
+            m.reverseStart |= (uint64_t)(uint32_t)_mm256_movemask_epi8(rstart) << shift;
+            m.reverseStop |= (uint64_t)(uint32_t)_mm256_movemask_epi8(rstop) << shift;
+        }
+    }
+    if (b * 64 < n)
+        scalarBlock(data, b * 64, n - b * 64, masks[b]);
+}
+#endif
+
+gene::codon::CodonKernel gene::codon::getKernel(const char *name)
+{
+    if (strcmp(name, "scalar") == 0)
+        return scanScalar;
+#ifdef CODON_KERNEL_X86
+    if (strcmp(name, "sse4.2") == 0 && __builtin_cpu_supports("sse4.2"))
+        return scanSse42;
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+        return scanAvx2;
+#endif
+    return nullptr;
+}
+
+/**
+ * @brief Get name of the fastest kernel supported by current CPU
+ *
+ * @return const char*
+ */
+static const char *detectKernel()
+{
+    const char *names[] = {"avx2", "sse4.2"};
+    for (auto name : names)
+        if (gene::codon::getKernel(name) != nullptr)
+            return name;
+    return "scalar";
+}
+
+static const char *kernelName = detectKernel();
+static const gene::codon::CodonKernel kernel = gene::codon::getKernel(kernelName);
+
+void gene::codon::scanCodons(const char *data, size_t n, CodonMasks *masks)
+{
+    kernel(data, n, masks);
+}
+
+const char *gene::codon::getKernelName()
+{
+    return kernelName;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef _CODON_KERNEL_H
+#define _CODON_KERNEL_H
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gene
+{
+    namespace codon
+    {
+        /**
+         * @brief Bitmasks of codons in a block of 64 positions. Bit k is
+         *        set if the codon starts at position k of the block (first
+         *        base on forward strand) is a start or stop codon. All
+         *        three phases are in the same mask.
+         */
+        struct CodonMasks
+        {
+            // AUG on forward strand
+            uint64_t start;
+            // UAA, UAG, UGA on forward strand
+            uint64_t stop;
+            // CAU, which is AUG on reverse strand
+            uint64_t reverseStart;
+            // UUA, CUA, UCA, which are stop codons on reverse strand
+            uint64_t reverseStop;
+        };
+
+        /**
+         * @brief Codon detection kernel
+         *
+         * @param data      Sequence data, n + 2 characters are read
+         * @param n         Number of codon positions
+         * @param masks     Output, (n + 63) / 64 masks
+         */
+        typedef void (*CodonKernel)(const char *data, size_t n, CodonMasks *masks);
+
+        /**
+         * @brief Find start and stop codons of n positions, with the
+         *        fastest kernel supported by current CPU (AVX2, SSE4.2
+         *        or scalar).
+         *
+         * @param data      Sequence data, n + 2 characters are read
+         * @param n         Number of codon positions
+         * @param masks     Output, (n + 63) / 64 masks
+         */
+        void scanCodons(const char *data, size_t n, CodonMasks *masks);
+
+        /**
+         * @brief Get name of kernel used by scanCodons
+         *
+         * @return const char*  "avx2", "sse4.2" or "scalar"
+         */
+        const char *getKernelName();
+
+        /**
+         * @brief Get kernel by name
+         *
+         * @param name      "avx2", "sse4.2" or "scalar"
+         * @return CodonKernel  nullptr, if kernel is not supported by
+         *                      current CPU.
+         */
+        CodonKernel getKernel(const char *name);
+    }
+}
+#endif
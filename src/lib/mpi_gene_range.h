@@ -0,0 +1,34 @@
+#pragma once
+#ifndef _MPI_GENE_RANGE_H
+#define _MPI_GENE_RANGE_H
+#include <cstddef>
+#include <mpi.h>
+#include "GeneRange.h"
+
+namespace gene
+{
+    /**
+     * @brief Create and commit MPI datatype of GeneRange. Its extent is
+     *        sizeof(GeneRange), so a vector of ranges can be sent as one
+     *        contiguous message.
+     *
+     * @return MPI_Datatype
+     */
+    inline MPI_Datatype createGeneRangeType()
+    {
+        const int nitems = 3;
+        int blocklengths[3] = {1, 1, 1};
+        MPI_Datatype types[3] = {MPI_UNSIGNED_LONG_LONG, MPI_UNSIGNED_LONG_LONG, MPI_INT8_T};
+        MPI_Aint offsets[3];
+        offsets[0] = offsetof(GeneRange, start);
+        offsets[1] = offsetof(GeneRange, end);
+        offsets[2] = offsetof(GeneRange, frame);
+        MPI_Datatype tmp_type, type;
+        MPI_Type_create_struct(nitems, blocklengths, offsets, types, &tmp_type);
+        MPI_Type_create_resized(tmp_type, 0, sizeof(GeneRange), &type);
+        MPI_Type_free(&tmp_type);
+        MPI_Type_commit(&type);
+        return type;
+    }
+}
+#endif
@@ -4,6 +4,13 @@
 #include <memory>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
+#include <stdint.h>
+#include "Codon.h"
+#include "PackedSequence.h"
+#include "codon_kernel.h"
+#include "range_collect.h"
+#include "Profile.h"
 
 /**
  * @brief Check if a sequence is DNA sequence
@@ -101,49 +108,164 @@ void reverse(std::string &seq)
     }
 }
 
-std::vector<gene::GeneRange> gene::getORFS(
-    const Sequence &seq, int8_t frame, size_t startLoc,
-    size_t endLoc)
+/**
+ * @brief Convert a codon position of scanned sequence back to the
+ *        position of original sequence, then build GeneRange object.
+ *
+ * @param i         Position of start codon
+ * @param j         Position of stop codon
+ * @param l         Length of sequence
+ * @param frame
+ * @return gene::GeneRange
+ */
+inline gene::GeneRange makeRange(size_t i, size_t j, size_t l, int8_t frame)
 {
-    endLoc -= 1;
-    // Get length
-    const auto l = seq.getSequence().length();
+    auto start = i;
+    auto end = j + 2;
+    if (frame < 0)
+    {
+        start = l - start - 1;
+        end = l - end - 1;
+    }
+    return {start, end, frame};
+}
 
-    // Check for valid frame value
-    if (frame == 0 || frame > 3 || frame < -3)
+/**
+ * @brief Read-only view of one strand of the original sequence buffer.
+ *        Reverse strand is read backward through the complement table,
+ *        so position i of reverse strand is base l - i - 1 of the
+ *        original sequence. No copy of the sequence is made.
+ *
+ * @tparam Reverse  View the reverse complement strand
+ */
+template <bool Reverse>
+struct StrandView
+{
+    const char *data;
+    size_t l;
+
+    /**
+     * @brief Get 2-bit code of base at position i of strand
+     *
+     * @param i
+     * @return uint8_t
+     */
+    inline uint8_t base(size_t i) const
     {
-        throw 1;
+        if (Reverse)
+            return gene::codon::table.complement[(uint8_t)data[l - i - 1]];
+        return gene::codon::table.code[(uint8_t)data[i]];
     }
+
+    /**
+     * @brief Get 6-bit code of codon at position i of strand,
+     *        INVALID_CODON if it contains non ACGTU base.
+     *
+     * @param i
+     * @return uint8_t
+     */
+    inline uint8_t codon(size_t i) const
+    {
+        uint8_t b0 = base(i), b1 = base(i + 1), b2 = base(i + 2);
+        if ((b0 | b1 | b2) & gene::codon::BASE_INVALID)
+            return gene::codon::INVALID_CODON;
+        return (b0 << 4) | (b1 << 2) | b2;
+    }
+};
+
+/**
+ * @brief Read-only view of one strand of a 2-bit packed sequence.
+ *        Codon code is read from packed words, and exception table is
+ *        checked with a cursor, which is cheap for monotonic access.
+ *
+ * @tparam Reverse  View the reverse complement strand
+ */
+template <bool Reverse>
+struct PackedStrandView
+{
+    const PackedSequence *packed;
+    size_t l;
+    // Cursor of exception table
+    mutable size_t run = 0;
+
+    /**
+     * @brief Check if codon at position o of original sequence contains
+     *        a base in exception table
+     *
+     * @param o
+     * @return true
+     * @return false
+     */
+    inline bool hasException(size_t o) const
+    {
+        const auto &ex = packed->getExceptions();
+        if (ex.empty())
+            return false;
+        // Move cursor to the first run that ends after o
+        while (run > 0 && ex[run - 1].start + ex[run - 1].length > o)
+            --run;
+        while (run < ex.size() && ex[run].start + ex[run].length <= o)
+            ++run;
+        return run < ex.size() && ex[run].start < o + 3;
+    }
+
+    /**
+     * @brief Get 6-bit code of codon at position i of strand,
+     *        INVALID_CODON if it contains non ACGTU base.
+     *
+     * @param i
+     * @return uint8_t
+     */
+    inline uint8_t codon(size_t i) const
+    {
+        size_t o = Reverse ? l - i - 3 : i;
+        if (hasException(o))
+            return gene::codon::INVALID_CODON;
+        auto c = (uint8_t)packed->codes(o, 3);
+        return Reverse ? gene::codon::table.reverseComplement[c] : c;
+    }
+};
+
+/**
+ * @brief Find orfs by scanning forward from every start codon until
+ *        the next stop codon. Works on a RNA copy of the strand.
+ *
+ * @param seq       Original sequence
+ * @param frame
+ * @param first     Position of first codon on the strand
+ * @param last      Bound of codon position on the strand (exclusive)
+ * @return std::vector<gene::GeneRange>
+ */
+std::vector<gene::GeneRange> forwardScan(
+    const std::string &seq, int8_t frame, size_t first, size_t last)
+{
+    const auto l = seq.length();
     // Get duplicate sequence data
-    std::string seqData = seq.getSequence();
-    // Convert DNA to RNA
-    bool dnaFlag = isDNA(seqData);
-    if (dnaFlag)
-        toRNA(seqData);
-    // Convert data based for negative frame
-    auto shift = frame;
-    if (frame < 0)
+    std::string seqData = seq;
     {
-        shift = -frame;
-        size_t org_end = endLoc;
-        endLoc = l - startLoc - 1;
-        startLoc = l - org_end - 1;
-        reverse(seqData);
-        to35RNA(seqData);
+        gene::profile::Scope scope(gene::profile::Strand);
+        // Convert DNA to RNA
+        bool dnaFlag = isDNA(seqData);
+        if (dnaFlag)
+            toRNA(seqData);
+        // Convert data based for negative frame
+        if (frame < 0)
+        {
+            reverse(seqData);
+            to35RNA(seqData);
+        }
     }
-    shift -= 1;
+    std::string_view seqView(seqData.c_str(), l);
     const std::set<std::string_view> endCodon{"UAA", "UAG", "UGA"};
     //                                         TTA    CTA    TCA
     const std::string startCodon = "AUG";
     //                              CAT
-    std::vector<gene::GeneRange> result;
-    std::string_view seqView(seqData.c_str(), l);
-    
-    #pragma omp parallel for shared(result, startCodon, endCodon, seqView)
-    for (int64_t i = startLoc + shift; i < endLoc + shift; i += 3)
-    {
-        // Because of OpenMP, put the i+3 judge inside of loop
-        if (i  < l - 3)
+    // Codon positions first, first + 3, ... before last
+    const int64_t n = last > first ? (last - first + 2) / 3 : 0;
+    auto result = gene::collectRanges(n, [&](int64_t k, std::vector<gene::GeneRange> &out)
+                                      {
+        size_t i = first + k * 3;
+        if (i < l - 3)
             // Check if current codon is start codon
             if (seqView.substr(i, 3).compare(startCodon) == 0)
                 // Find if it has a end codon
@@ -151,18 +273,356 @@ std::vector<gene::GeneRange> gene::getORFS(
                 {
                     if (endCodon.find(seqView.substr(j, 3)) != endCodon.end())
                     {
-                        auto start = (size_t) i;
-                        auto end = (size_t) j + 2;
-                        if (frame < 0)
-                        {
-                            start = l - start - 1;
-                            end = l - end - 1;
-                        }
-                        #pragma omp critical
-                        result.push_back({start, end, frame});
+                        out.push_back(makeRange(i, j, l, frame));
                         break;
                     }
+                } });
+    return result;
+}
+
+/**
+ * @brief Find orfs by one backward sweep of the frame. The sweep
+ *        remembers position of the next stop codon, so every start
+ *        codon is resolved in O(1). Results are in same order of a
+ *        sequential forward scan.
+ *
+ * @tparam Strand    StrandView or PackedStrandView
+ * @param strand    Strand of frame
+ * @param frame
+ * @param first     Position of first codon on the strand
+ * @param last      Bound of codon position on the strand (exclusive)
+ * @return std::vector<gene::GeneRange>
+ */
+template <typename Strand>
+std::vector<gene::GeneRange> linearScan(
+    const Strand &strand, int8_t frame, size_t first, size_t last)
+{
+    const auto l = strand.l;
+    std::vector<gene::GeneRange> result;
+    // Neither start codon nor stop codon may touch last base
+    if (l < 4)
+        return result;
+    last = last < l - 3 ? last : l - 3;
+    if (first >= last)
+        return result;
+    // Last start codon position in frame
+    size_t i = last - 1 - (last - 1 - first) % 3;
+    // Find the first stop codon behind the last start codon
+    size_t nextStop = INVALID_RANGE_LOC;
+    for (size_t j = i + 3; j < l - 3; j += 3)
+        if (gene::codon::isStop(strand.codon(j)))
+        {
+            nextStop = j;
+            break;
+        }
+    // Sweep backward, resolve start codon with remembered stop codon
+    for (;; i -= 3)
+    {
+        auto codon = strand.codon(i);
+        if (gene::codon::isStart(codon))
+        {
+            if (nextStop != INVALID_RANGE_LOC)
+                result.push_back(makeRange(i, nextStop, l, frame));
+        }
+        else if (gene::codon::isStop(codon))
+            nextStop = i;
+        if (i < first + 3)
+            break;
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+// Bits of positions 0, 3, 6, ..., 63 of a 64-bit mask
+const uint64_t PHASE_MASK = 0x9249249249249249ULL;
+// Number of codon positions of each kernel call
+const size_t MASK_CHUNK = 64 * 256;
+
+/**
+ * @brief Get bitmask of a block, that has bits set for positions whose
+ *        distance to the first codon of frame is a multiple of 3.
+ *
+ * @param distance  Distance of the first bit of block to the first
+ *                  codon of frame
+ * @return uint64_t
+ */
+inline uint64_t phaseMask(size_t distance)
+{
+    return PHASE_MASK << ((3 - distance % 3) % 3);
+}
+
+/**
+ * @brief Get bitmask of positions of a block that are less than bound
+ *
+ * @param blockStart    Position of the first bit of block
+ * @param bound
+ * @return uint64_t
+ */
+inline uint64_t boundMask(size_t blockStart, size_t bound)
+{
+    if (bound <= blockStart)
+        return 0;
+    if (bound - blockStart >= 64)
+        return ~0ULL;
+    return (1ULL << (bound - blockStart)) - 1;
+}
+
+/**
+ * @brief Reserve space of result for start codons in masks of a chunk
+ *
+ * @param result
+ * @param masks
+ * @param n         Number of codon positions of chunk
+ * @param reverse   Count start codons of reverse strand
+ */
+inline void reserveStarts(std::vector<gene::GeneRange> &result,
+                          const std::vector<gene::codon::CodonMasks> &masks,
+                          size_t n, bool reverse)
+{
+    size_t count = 0;
+    for (size_t b = 0; b * 64 < n; ++b)
+        count += __builtin_popcountll(reverse ? masks[b].reverseStart : masks[b].start);
+    // Every phase has about one third of start codons
+    count = result.size() + count / 3 + 1;
+    if (result.capacity() < count)
+        result.reserve(count * 2);
+}
+
+/**
+ * @brief Find orfs from codon bitmasks of the SIMD kernel. Masks are
+ *        computed chunk by chunk, and codons of the frame are visited
+ *        in order with ctz iteration. Results are in same order of a
+ *        sequential forward scan.
+ *
+ * @param data      Original sequence
+ * @param l         Length of sequence
+ * @param frame
+ * @param first     Position of first codon on the strand
+ * @param last      Bound of codon position on the strand (exclusive)
+ * @return std::vector<gene::GeneRange>
+ */
+std::vector<gene::GeneRange> bitmaskScan(
+    const char *data, size_t l, int8_t frame, size_t first, size_t last)
+{
+    std::vector<gene::GeneRange> result;
+    // Neither start codon nor stop codon may touch last base
+    if (l < 4)
+        return result;
+    last = last < l - 3 ? last : l - 3;
+    if (first >= last)
+        return result;
+    std::vector<gene::codon::CodonMasks> masks(MASK_CHUNK / 64);
+    if (frame > 0)
+    {
+        // Start codons wait for the next stop codon of frame
+        std::vector<size_t> pending;
+        for (size_t base = first; base < l - 3; base += MASK_CHUNK)
+        {
+            auto n = std::min(MASK_CHUNK, l - 3 - base);
+            gene::codon::scanCodons(data + base, n, masks.data());
+            reserveStarts(result, masks, n, false);
+            for (size_t b = 0; b * 64 < n; ++b)
+            {
+                auto blockStart = base + b * 64;
+                auto inFrame = phaseMask(blockStart - first);
+                auto starts = masks[b].start & inFrame & boundMask(blockStart, last);
+                auto stops = masks[b].stop & inFrame;
+                for (auto events = starts | stops; events != 0; events &= events - 1)
+                {
+                    auto k = __builtin_ctzll(events);
+                    if ((starts >> k) & 1)
+                        pending.push_back(blockStart + k);
+                    else
+                    {
+                        for (auto i : pending)
+                            result.push_back(makeRange(i, blockStart + k, l, frame));
+                        pending.clear();
+                    }
                 }
+            }
+            // All start codons are resolved
+            if (base + n >= last && pending.empty())
+                break;
+        }
+        return result;
+    }
+    // Reverse strand: position i of strand is codon at l - i - 3 of
+    // original sequence, and stop codon is before start codon.
+    auto lastStart = last - 1 - (last - 1 - first) % 3;
+    size_t low = l - 3 - lastStart, high = l - 3 - first;
+    // Find the stop codon before the first start codon
+    StrandView<true> strand{data, l};
+    size_t lastStop = INVALID_RANGE_LOC;
+    for (size_t o = low; o >= 4;)
+    {
+        o -= 3;
+        if (gene::codon::isStop(strand.codon(l - 3 - o)))
+        {
+            lastStop = o;
+            break;
+        }
+    }
+    for (size_t base = low; base <= high; base += MASK_CHUNK)
+    {
+        auto n = std::min(MASK_CHUNK, high + 1 - base);
+        gene::codon::scanCodons(data + base, n, masks.data());
+        reserveStarts(result, masks, n, true);
+        for (size_t b = 0; b * 64 < n; ++b)
+        {
+            auto blockStart = base + b * 64;
+            auto inFrame = phaseMask(blockStart - low);
+            auto starts = masks[b].reverseStart & inFrame;
+            auto stops = masks[b].reverseStop & inFrame;
+            for (auto events = starts | stops; events != 0; events &= events - 1)
+            {
+                auto k = __builtin_ctzll(events);
+                if ((stops >> k) & 1)
+                    lastStop = blockStart + k;
+                else if (lastStop != INVALID_RANGE_LOC)
+                    result.push_back(makeRange(l - 3 - (blockStart + k), l - 3 - lastStop, l, frame));
+            }
+        }
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+bool gene::parseScanMode(const std::string &name, gene::ScanMode &mode)
+{
+    if (name == "forward")
+        mode = gene::ScanMode::Forward;
+    else if (name == "linear")
+        mode = gene::ScanMode::Linear;
+    else if (name == "simd")
+        mode = gene::ScanMode::Simd;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @brief Check if an in-frame start codon comes before position i of
+ *        strand, with no stop codon between
+ *
+ * @tparam Strand    StrandView
+ * @param strand
+ * @param i         Position of start codon on the strand
+ * @return true
+ * @return false
+ */
+template <typename Strand>
+bool hasLongerORF(const Strand &strand, size_t i)
+{
+    while (i >= 3)
+    {
+        i -= 3;
+        auto codon = strand.codon(i);
+        if (gene::codon::isStop(codon))
+            return false;
+        if (gene::codon::isStart(codon))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Remove ORFs of a strand that have a longer ORF of the same stop
+ *        codon, see gene::keepLongestORFS
+ *
+ * @tparam Strand    StrandView
+ * @param strand
+ * @param orfs
+ * @return size_t
+ */
+template <typename Strand>
+size_t keepLongest(const Strand &strand, std::vector<gene::GeneRange> &orfs)
+{
+    const auto l = strand.l;
+    size_t kept = 0, lastEnd = INVALID_RANGE_LOC;
+    for (size_t k = 0; k < orfs.size(); ++k)
+    {
+        // ORFs of one stop codon are next to each other, previous one is longer
+        auto orf = orfs[k];
+        bool nested = orf.end == lastEnd;
+        lastEnd = orf.end;
+        if (nested)
+            continue;
+        size_t i = orf.start < orf.end ? orf.start : l - orf.start - 1;
+        if (!hasLongerORF(strand, i))
+            orfs[kept++] = orf;
+    }
+    size_t removed = orfs.size() - kept;
+    orfs.resize(kept);
+    return removed;
+}
+
+size_t gene::keepLongestORFS(const Sequence &seq, int8_t frame, std::vector<GeneRange> &orfs)
+{
+    gene::profile::Scope scope(gene::profile::Scan);
+    const auto &data = seq.getSequence();
+    size_t removed = frame < 0
+                         ? keepLongest(StrandView<true>{data.c_str(), data.length()}, orfs)
+                         : keepLongest(StrandView<false>{data.c_str(), data.length()}, orfs);
+    gene::profile::count(gene::profile::OrfsElided, removed);
+    return removed;
+}
+
+/**
+ * @brief Scan a frame with engine of mode
+ *
+ * @param seq
+ * @param frame
+ * @param first     Position of first codon on the strand
+ * @param last      Bound of codon position on the strand (exclusive)
+ * @param mode
+ * @return std::vector<gene::GeneRange>
+ */
+std::vector<gene::GeneRange> scanFrame(
+    const Sequence &seq, int8_t frame, size_t first, size_t last, gene::ScanMode mode)
+{
+    const auto &seqData = seq.getSequence();
+    const auto l = seqData.length();
+    if (mode == gene::ScanMode::Forward)
+        return forwardScan(seqData, frame, first, last);
+    if (mode == gene::ScanMode::Simd)
+        return bitmaskScan(seqData.c_str(), l, frame, first, last);
+    // Read codon from packed sequence if it is available
+    auto packed = seq.getPacked();
+    if (packed != nullptr && frame < 0)
+        return linearScan(PackedStrandView<true>{packed, l}, frame, first, last);
+    if (packed != nullptr)
+        return linearScan(PackedStrandView<false>{packed, l}, frame, first, last);
+    if (frame < 0)
+        return linearScan(StrandView<true>{seqData.c_str(), l}, frame, first, last);
+    return linearScan(StrandView<false>{seqData.c_str(), l}, frame, first, last);
+}
+
+std::vector<gene::GeneRange> gene::getORFS(
+    const Sequence &seq, int8_t frame, size_t startLoc,
+    size_t endLoc, gene::ScanMode mode)
+{
+    endLoc -= 1;
+    // Get length
+    const auto l = seq.getSequence().length();
+
+    // Check for valid frame value
+    if (frame == 0 || frame > 3 || frame < -3)
+    {
+        throw 1;
+    }
+    // Convert location for negative frame, the reverse strand is
+    // scanned from the end of sequence
+    auto shift = frame;
+    if (frame < 0)
+    {
+        shift = -frame;
+        size_t org_end = endLoc;
+        endLoc = l - startLoc - 1;
+        startLoc = l - org_end - 1;
     }
+    shift -= 1;
+    gene::profile::Scope scope(gene::profile::Scan);
+    auto result = scanFrame(seq, frame, startLoc + shift, endLoc + shift, mode);
+    gene::profile::count(gene::profile::OrfsFound, result.size());
     return result;
 }
\ No newline at end of file
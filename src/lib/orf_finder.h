@@ -7,7 +7,43 @@
 #include "Fasta.h"
 #include "GeneRange.h"
 namespace gene
-{    
+{
+     /**
+      * @brief ORF scanning engine used by getORFS. Every engine returns
+      *        the same GeneRange objects in the same order.
+      */
+     enum class ScanMode
+     {
+          /**
+           * @brief Scan forward from every start codon until the next
+           *        stop codon in frame.
+           */
+          Forward,
+          /**
+           * @brief One backward sweep per frame, that remembers the
+           *        position of next stop codon, so every start codon
+           *        is resolved in O(1). Codons are read from the packed
+           *        representation, if the sequence is packed.
+           */
+          Linear,
+          /**
+           * @brief Find start and stop codons of all phases with SIMD
+           *        kernel (AVX2, SSE4.2 or scalar by CPU dispatch), then
+           *        build ranges from the bitmasks.
+           */
+          Simd
+     };
+
+     /**
+      * @brief Parse name of scan mode ("forward", "linear" or "simd").
+      *
+      * @param name
+      * @param mode      Parsed scan mode
+      * @return true     Name is a valid scan mode.
+      * @return false    Name is not a valid scan mode.
+      */
+     bool parseScanMode(const std::string &name, ScanMode &mode);
+
      /**
       * @brief Get orfs from dna/rna sequence, returns vector of GeneRange object.
       * 
@@ -15,10 +51,28 @@ namespace gene
       * @param frame 
       * @param startLoc 
       * @param endLoc 
+      * @param mode     Scanning engine
       * @return std::vector<GeneRange> 
       */
      std::vector<GeneRange> getORFS(
          const Sequence &seq, int8_t frame, size_t startLoc,
-         size_t endLoc);
+         size_t endLoc, ScanMode mode = ScanMode::Linear);
+
+     /**
+      * @brief Keep the longest ORF of every stop codon. getORFS returns an
+      *        ORF for every start codon before a stop codon, so nested ORFs
+      *        share one stop codon. An ORF is removed if an in-frame start
+      *        codon comes before it on the strand with no stop codon
+      *        between, which is a longer ORF of the same stop codon. Start
+      *        codons before seq are not seen, so an ORF of a window is kept
+      *        if the window does not reach back to a stop codon.
+      *
+      * @param seq
+      * @param frame
+      * @param orfs     ORFs of frame of seq, in order of getORFS. Kept ORFs
+      *                 stay in order.
+      * @return size_t  Number of removed ORFs
+      */
+     size_t keepLongestORFS(const Sequence &seq, int8_t frame, std::vector<GeneRange> &orfs);
 }
 #endif
\ No newline at end of file
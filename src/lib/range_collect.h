@@ -0,0 +1,66 @@
+#pragma once
+#ifndef _RANGE_COLLECT_H
+#define _RANGE_COLLECT_H
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <omp.h>
+#include "GeneRange.h"
+
+namespace gene
+{
+    /**
+     * @brief Collect ranges produced by a parallel loop over [0, n), in
+     *        loop order. Every thread runs a contiguous block of the loop
+     *        and appends to its own buffer, then buffers are copied to
+     *        result at offsets of an exclusive prefix sum of their sizes,
+     *        in parallel. There is no lock, and result is same as running
+     *        the loop sequentially.
+     *
+     * @tparam Produce  Callable as produce(i, std::vector<GeneRange> &out),
+     *                  that appends ranges of iteration i to out. It is
+     *                  called from multiple threads.
+     * @param n         Number of iterations
+     * @param produce
+     * @return std::vector<GeneRange>
+     */
+    template <typename Produce>
+    std::vector<GeneRange> collectRanges(int64_t n, const Produce &produce)
+    {
+        const int threads = omp_get_max_threads();
+        std::vector<std::vector<GeneRange>> buffers(threads);
+        std::vector<size_t> offsets(threads + 1, 0);
+        std::vector<GeneRange> result;
+        #pragma omp parallel num_threads(threads)
+        {
+            const int t = omp_get_thread_num(), team = omp_get_num_threads();
+            auto &out = buffers[t];
+            for (int64_t i = n * t / team; i < n * (t + 1) / team; ++i)
+                produce(i, out);
+            #pragma omp barrier
+            #pragma omp single
+            {
+                for (int k = 0; k < threads; ++k)
+                    offsets[k + 1] = offsets[k] + buffers[k].size();
+                result.resize(offsets[threads]);
+            }
+            std::copy(out.begin(), out.end(), result.begin() + offsets[t]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Keep valid ranges of judge results, in order
+     *
+     * @param judged
+     * @return std::vector<GeneRange>
+     */
+    inline std::vector<GeneRange> compactRanges(const std::vector<GeneRange> &judged)
+    {
+        return collectRanges((int64_t)judged.size(), [&](int64_t i, std::vector<GeneRange> &out)
+                             {
+            if (judged[i])
+                out.push_back(judged[i]); });
+    }
+}
+#endif
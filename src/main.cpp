@@ -1,8 +1,17 @@
 #include "./lib/Fasta.h"
+#include "./lib/FastaWriter.h"
 #include "./lib/InputParser.h"
 #include "./lib/orf_finder.h"
 #include "./lib/gene_judge.h"
+#include "./lib/JudgeContext.h"
+#include "./lib/range_collect.h"
+#include "./lib/ChunkScanner.h"
+#include "./lib/MappedFasta.h"
+#include "./lib/TaskScheduler.h"
+#include "./lib/BoundedQueue.h"
+#include "./lib/Profile.h"
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <omp.h>
 #include <string>
@@ -10,92 +19,428 @@
 #include <memory>
 #include <sstream>
 #include <chrono>
-
-/**
- * @brief C++11 version of sprintf
- *        Reference: https://stackoverflow.com/questions/2342162/
- * @tparam Args
- * @param format
- * @param args
- * @return std::string
- */
-template <typename... Args>
-std::string string_format(const std::string &format, Args... args)
-{
-    int size_s = std::snprintf(nullptr, 0, format.c_str(), args...) + 1; // Extra space for '\0'
-    if (size_s <= 0)
-    {
-        throw std::runtime_error("Error during formatting.");
-    }
-    auto size = static_cast<size_t>(size_s);
-    std::unique_ptr<char[]> buf(new char[size]);
-    std::snprintf(buf.get(), size, format.c_str(), args...);
-    return std::string(buf.get(), buf.get() + size - 1); // We don't want the '\0' inside
-}
+#include <algorithm>
+#include <future>
+#include <functional>
+#include <thread>
+#include <iomanip>
 
 /**
  * @brief Get the gene object, take isGene function from dynamic linked lib.
+ *        ORFs are judged in batches of similar cost with the judge
+ *        context of sequence.
  *
  * @param orfs    vector that contains ORFS, to check if it is a gene.
- * @param seq     Sequence to judge.
+ * @param judge   Judge context of sequence to judge.
  * @param start   Index of start ORF object
  * @param end     Index of end ORF object.
  * @return std::vector<gene::GeneRange>
  */
 std::vector<gene::GeneRange> get_gene(
-    const std::vector<gene::GeneRange> &orfs, const Sequence &seq,
-    size_t start, size_t end)
+    const std::vector<gene::GeneRange> &orfs,
+    const gene::JudgeContext &judge, size_t start, size_t end)
 {
-    std::vector<gene::GeneRange> result;
-    result.resize(orfs.size());
-    std::atomic<size_t> resultIndex = 0;
-    #pragma omp parallel for
-    for (int64_t i = start; i < end; ++i)
+    std::vector<gene::GeneRange> judged(end - start);
+    // Batches of about 256 ORFs on average, with similar judge cost
+    auto bounds = judge.splitBatches(
+        orfs.data() + start, end - start,
+        std::max<size_t>(omp_get_max_threads() * 16, (end - start) / 256));
+    #pragma omp parallel for schedule(dynamic)
+    for (int64_t b = 0; b < (int64_t)bounds.size() - 1; ++b)
+        judge.judge(&orfs[start + bounds[b]], bounds[b + 1] - bounds[b], &judged[bounds[b]]);
+    // Keep genes
+    return gene::compactRanges(judged);
+}
+
+// Bases of a scan task, a multiple of 3 so chunks keep phase of frames
+const size_t TASK_CHUNK = 3 << 18;
+// ORFs of a judge task
+const size_t JUDGE_BATCH = 1024;
+// Sequences read ahead of output per worker, and bases of them
+const size_t JOBS_PER_WORKER = 4;
+const size_t MAX_JOB_BASES = (size_t)256 << 20;
+
+/**
+ * @brief Busy and idle time of a pipeline stage in nanoseconds, and
+ *        number of items it processed
+ */
+struct StageTime
+{
+    std::atomic<int64_t> busy{0};
+    std::atomic<int64_t> idle{0};
+    std::atomic<size_t> items{0};
+};
+
+/**
+ * @brief Get nanoseconds since a time point
+ *
+ * @param since
+ * @return int64_t
+ */
+inline int64_t nanoseconds(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * @brief Stages of gene finding pipeline. Reader thread reads sequences,
+ *        scan tasks find ORFs of a chunk of a frame, judge tasks judge a
+ *        batch of ORFs, format tasks format genes of a chunk, and writer
+ *        thread writes sequences in input order.
+ */
+struct Pipeline
+{
+    StageTime read;
+    StageTime scan;
+    StageTime judge;
+    StageTime format;
+    StageTime write;
+
+    /**
+     * @brief Print busy and idle time of stages. Idle time of task stages
+     *        is the time workers had no task.
+     *
+     * @param out
+     * @param workers   Number of workers
+     * @param wall      Wall time of pipeline in nanoseconds
+     */
+    void report(std::ostream &out, size_t workers, int64_t wall) const
     {
-        auto resSeq = isGene(orfs[i], seq);
-        if (resSeq)
-            result[resultIndex++] = resSeq;
+        int64_t tasks = this->scan.busy + this->judge.busy + this->format.busy;
+        auto line = [&](const char *name, const StageTime &stage, int64_t idle)
+        {
+            out << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(3)
+                << std::setw(10) << stage.busy / 1e9 << std::setw(10) << idle / 1e9
+                << std::setw(12) << stage.items << std::endl;
+        };
+        out << std::left << std::setw(8) << "stage" << std::right << std::setw(10) << "busy(s)"
+            << std::setw(10) << "idle(s)" << std::setw(12) << "items" << std::endl;
+        line("read", this->read, this->read.idle);
+        line("scan", this->scan, 0);
+        line("judge", this->judge, 0);
+        line("format", this->format, 0);
+        out << std::left << std::setw(8) << "workers" << std::right << std::setw(10) << tasks / 1e9
+            << std::setw(10) << std::max<int64_t>(0, (int64_t)workers * wall - tasks) / 1e9
+            << std::setw(12) << workers << std::endl;
+        line("write", this->write, this->write.idle);
     }
-    result.resize(resultIndex);
-    return result;
+};
+
+/**
+ * @brief ORFs of a chunk of a frame, judged by several judge tasks
+ */
+struct ChunkJob
+{
+    std::vector<gene::GeneRange> orfs;
+    std::vector<gene::GeneRange> judged;
+    std::atomic<size_t> remaining{0};
+};
+
+/**
+ * @brief A sequence in flight. Its genes are found by tasks, and
+ *        formatted by tasks into output buffers, one per (frame, chunk).
+ *        Buffers are in output order: frame -3 to 3, and chunks in
+ *        order of strand of frame.
+ */
+struct SequenceJob
+{
+    Sequence seq;
+    std::unique_ptr<gene::JudgeContext> judge;
+    std::vector<FastaBuffer> output;
+    std::atomic<size_t> remaining;
+    std::promise<void> done;
+    std::future<void> finished;
+
+    explicit SequenceJob(Sequence &&seq)
+        : seq(std::move(seq)), remaining(0), finished(done.get_future()) {}
+};
+
+/**
+ * @brief Format genes of a judged chunk, finish sequence job after its
+ *        last chunk.
+ *
+ * @param job
+ * @param chunk
+ * @param t             Index of output buffer of chunk
+ * @param frame
+ * @param print_pattern
+ * @param line_width
+ * @param stats
+ */
+void format_chunk(SequenceJob &job, const ChunkJob &chunk, size_t t, int frame,
+                  const char *print_pattern, size_t line_width, Pipeline &stats)
+{
+    gene::profile::Scope scope(gene::profile::Format);
+    auto since = std::chrono::steady_clock::now();
+    auto &out = job.output[t];
+    size_t genes = 0;
+    for (auto &range : chunk.judged)
+        if (range)
+        {
+            out.appendLabel(print_pattern, job.seq.getLabel().c_str(), frame, range.start, range.end);
+            out.appendBases(job.seq.getSequence().data() + range.abs_start(), range.length(), line_width);
+            ++genes;
+        }
+    stats.format.items += genes;
+    stats.format.busy += nanoseconds(since);
+    gene::profile::count(gene::profile::Genes, genes);
+    if (job.remaining.fetch_sub(1) == 1)
+        job.done.set_value();
+}
+
+/**
+ * @brief Submit tasks of a sequence job. First task packs sequence and
+ *        prepares judge context, then it submits a scan task for each
+ *        chunk of each frame. A scan task submits judge tasks for
+ *        batches of its ORFs of similar cost, and the last judge task of
+ *        a chunk formats its genes.
+ *
+ * @param scheduler
+ * @param job
+ * @param print_pattern
+ * @param line_width
+ * @param scan_mode
+ * @param packed
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param stats
+ */
+void submit_sequence(gene::TaskScheduler &scheduler, SequenceJob &job,
+                     const char *print_pattern, size_t line_width,
+                     gene::ScanMode scan_mode, bool packed, bool longest, Pipeline &stats)
+{
+    scheduler.submit([=, &scheduler, &job, &stats]()
+                     {
+        auto since = std::chrono::steady_clock::now();
+        if (packed)
+            job.seq.pack();
+        // Judge context is shared by all frames
+        job.judge.reset(new gene::JudgeContext(job.seq));
+        stats.judge.busy += nanoseconds(since);
+        const size_t l = job.seq.getSequence().length();
+        const size_t chunks = std::max<size_t>(1, (l + TASK_CHUNK - 1) / TASK_CHUNK);
+        job.output.resize(6 * chunks);
+        job.remaining = 6 * chunks;
+        for (size_t t = 0; t < 6 * chunks; ++t)
+            scheduler.submit([=, &scheduler, &job, &stats]()
+                             {
+                auto since = std::chrono::steady_clock::now();
+                // Frames -3, -2, -1, 1, 2, 3
+                int frame = (int)(t / chunks) - 3;
+                frame += frame >= 0;
+                // Chunk [a, b) of strand of frame
+                size_t a = t % chunks * TASK_CHUNK, b = std::min(l, a + TASK_CHUNK);
+                auto chunk = std::make_shared<ChunkJob>();
+                chunk->orfs = frame > 0
+                                  ? gene::getORFS(job.seq, frame, a, b, scan_mode)
+                                  : gene::getORFS(job.seq, frame, l - b, l - a, scan_mode);
+                // Longer ORF of a stop codon may start in previous chunk, it
+                // is seen in the whole sequence
+                if (longest)
+                    gene::keepLongestORFS(job.seq, frame, chunk->orfs);
+                const size_t n = chunk->orfs.size();
+                stats.scan.items += 1;
+                stats.scan.busy += nanoseconds(since);
+                if (n == 0)
+                {
+                    format_chunk(job, *chunk, t, frame, print_pattern, line_width, stats);
+                    return;
+                }
+                chunk->judged.resize(n);
+                auto bounds = job.judge->splitBatches(chunk->orfs.data(), n,
+                                                      (n + JUDGE_BATCH - 1) / JUDGE_BATCH);
+                chunk->remaining = bounds.size() - 1;
+                for (size_t k = 0; k + 1 < bounds.size(); ++k)
+                {
+                    size_t first = bounds[k], count = bounds[k + 1] - bounds[k];
+                    scheduler.submit([=, &job, &stats]()
+                                     {
+                        auto since = std::chrono::steady_clock::now();
+                        job.judge->judge(&chunk->orfs[first], count, &chunk->judged[first]);
+                        stats.judge.items += count;
+                        stats.judge.busy += nanoseconds(since);
+                        if (chunk->remaining.fetch_sub(1) == 1)
+                            format_chunk(job, *chunk, t, frame, print_pattern, line_width, stats); });
+                } }); });
 }
 
 /**
  * @brief Finding gene from fasta and save it to another fasta file.
+ *        A reader thread reads sequences and submits their tasks, tasks
+ *        scan, judge and format genes on a work stealing scheduler, and
+ *        a writer thread writes finished sequences in input order. The
+ *        reader and writer are connected by a bounded queue, so reading
+ *        and writing overlap compute with bounded memory. Output is same
+ *        as scanning sequences one by one.
  * 
  * @param input_filepath 
  * @param output_filepath 
  * @param print_pattern 
  * @param line_width 
+ * @param scan_mode 
+ * @param packed   Use 2-bit packed representation of sequences
+ * @param longest  Judge only the longest ORF of every stop codon
+ * @param mapped   Read input file by memory mapping
+ * @param report   Print busy and idle time of stages to stderr
  * @return int 
  */
 int finding_gene(const char *input_filepath, const char *output_filepath,
-         const char *print_pattern, size_t line_width = 70)
+         const char *print_pattern, size_t line_width = 70,
+         gene::ScanMode scan_mode = gene::ScanMode::Linear, bool packed = false,
+         bool longest = false, bool mapped = false, bool report = false)
 {
+    auto start = std::chrono::steady_clock::now();
     // Open files
     Fasta f(input_filepath, std::ios::in);
     Fasta f_out(output_filepath, std::ios::out);
-    // Get all sequences
-    for (auto seq = f.getNextSequence(); seq; seq = f.getNextSequence())
-    {
-        
-        for (int frame = -3; frame <= 3; ++frame) {
-            if (frame==0)
-                continue;
-            // Get orfs
-            auto orfs = gene::getORFS(seq, frame, 0,
-                                    seq.getSequence().length());
-            // Filter orfs
-            auto g = get_gene(orfs, seq, 0, orfs.size());
-            // Save gene to file
-            for (auto i = 0; i < g.size(); i++)
+    std::unique_ptr<MappedFasta> mf(mapped ? new MappedFasta(input_filepath) : nullptr);
+    size_t record = 0;
+    auto next_sequence = [&]()
+    { return mapped ? mf->getSequence(record++) : f.getNextSequence(); };
+    Pipeline stats;
+    gene::TaskScheduler scheduler;
+    // Sequences in flight, in input order
+    gene::BoundedQueue<SequenceJob *> jobs(scheduler.size() * JOBS_PER_WORKER);
+    std::atomic<size_t> bases(0);
+    // Read sequences and submit their tasks
+    std::thread reader([&]()
+                       {
+        auto since = std::chrono::steady_clock::now();
+        for (auto seq = next_sequence(); seq; seq = next_sequence())
+        {
+            auto length = seq.getSequence().length();
+            auto job = new SequenceJob(std::move(seq));
+            submit_sequence(scheduler, *job, print_pattern, line_width, scan_mode, packed, longest, stats);
+            stats.read.items += 1;
+            stats.read.busy += nanoseconds(since);
+            // Wait for room of read ahead
+            since = std::chrono::steady_clock::now();
+            jobs.push(job);
+            bases += length;
+            for (size_t tries = 0; bases.load() >= MAX_JOB_BASES; ++tries)
+                std::this_thread::sleep_for(std::chrono::microseconds(tries < 64 ? 50 : 1000));
+            stats.read.idle += nanoseconds(since);
+            since = std::chrono::steady_clock::now();
+        }
+        stats.read.busy += nanoseconds(since);
+        jobs.close(); });
+    // Save genes of sequences to file in order
+    std::thread writer([&]()
+                       {
+        SequenceJob *job;
+        auto since = std::chrono::steady_clock::now();
+        while (jobs.pop(job))
+        {
+            job->finished.wait();
+            stats.write.idle += nanoseconds(since);
+            since = std::chrono::steady_clock::now();
+            for (auto &out : job->output)
             {
-                Sequence seq_out(
-                    string_format(print_pattern,seq.getLabel().c_str(),frame,g[i].start,g[i].end),
-                    seq.getSequence().substr(
-                        g[i].abs_start(), g[i].length()));
-                f_out.write(seq_out, line_width);
+                f_out.writeRaw(out.str());
+                stats.write.items += out.size();
             }
+            bases -= job->seq.getSequence().length();
+            delete job;
+            stats.write.busy += nanoseconds(since);
+            since = std::chrono::steady_clock::now();
+        }
+        stats.write.idle += nanoseconds(since); });
+    reader.join();
+    writer.join();
+    // Close file
+    f.close();
+    f_out.close();
+    if (report)
+        stats.report(std::cerr, scheduler.size(), nanoseconds(start));
+    // Return 0 for sucessful.
+    return 0;
+}
+
+/**
+ * @brief Finding gene from fasta chunk by chunk, with bounded memory.
+ *        Next chunk is read while the current window is scanned.
+ *
+ * @param input_filepath
+ * @param output_filepath
+ * @param print_pattern
+ * @param line_width
+ * @param scan_mode
+ * @param packed        Use 2-bit packed representation of sequences
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param chunk_size    Bases read from file at once
+ * @param overlap       Bases kept around ORF for gene judge
+ * @param mapped        Read input file by memory mapping
+ * @return int
+ */
+int finding_gene_chunked(const char *input_filepath, const char *output_filepath,
+         const char *print_pattern, size_t line_width,
+         gene::ScanMode scan_mode, bool packed, bool longest, size_t chunk_size, size_t overlap,
+         bool mapped = false)
+{
+    // Open files
+    Fasta f(input_filepath, std::ios::in);
+    Fasta f_out(output_filepath, std::ios::out);
+    std::unique_ptr<MappedFasta> mf(mapped ? new MappedFasta(input_filepath) : nullptr);
+    // Length of records is needed for phase of reverse frames
+    std::vector<size_t> lengths;
+    if (mapped)
+        for (size_t i = 0; i < mf->getIndex().size(); ++i)
+            lengths.push_back(mf->getIndex()[i].length);
+    else
+        lengths = f.getRecordLengths();
+    for (size_t record = 0; record < lengths.size(); ++record)
+    {
+        size_t position = 0;
+        auto read_chunk = [&, record](size_t n, bool &last)
+        {
+            if (!mapped)
+                return f.getNextChunk(n, last);
+            position += n;
+            last = position >= lengths[record];
+            return mf->getRegion(record, position - n, position);
+        };
+        gene::ChunkScanner scanner(lengths[record], overlap, scan_mode, packed);
+        bool last = false;
+        auto chunk = read_chunk(scanner.getReadSize(chunk_size), last);
+        if (!chunk)
+            break;
+        while (true)
+        {
+            scanner.push(chunk);
+            // Read next chunk in background
+            bool next_last = false;
+            std::future<Sequence> next;
+            if (!last)
+                next = std::async(std::launch::async, read_chunk,
+                                  scanner.getReadSize(chunk_size), std::ref(next_last));
+            const auto &window = scanner.getWindow();
+            auto offset = scanner.getOffset();
+            gene::JudgeContext judge(window);
+            for (int frame = -3; frame <= 3; ++frame) {
+                if (frame==0)
+                    continue;
+                // Get orfs
+                auto orfs = scanner.getORFS(frame);
+                if (longest)
+                    gene::keepLongestORFS(window, frame, orfs);
+                // Filter orfs
+                auto g = get_gene(orfs, judge, 0, orfs.size());
+                // Save gene to file
+                writeRecords(f_out, g.size(), [&](size_t i, FastaBuffer &out)
+                {
+                    out.appendLabel(print_pattern, window.getLabel().c_str(), frame,
+                                    g[i].start + offset, g[i].end + offset);
+                    out.appendBases(window.getSequence().data() + g[i].abs_start(), g[i].length(),
+                                    line_width);
+                });
+            }
+            if (last)
+                break;
+            scanner.advance();
+            chunk = next.get();
+            last = next_last;
+            if (!chunk)
+                break;
         }
     }
     // Close file
@@ -114,10 +459,14 @@ void print_usage(const char* prog)
 {
     std::cout << "Usage: " << prog << " --input INPUT_FILE_PATH"
               << " --output OUTPUT_FILE_PATH"
-              << " [--pattern LABEL_PATTERN --output-line-width WIDTH --time]" << std::endl;
+              << " [--pattern LABEL_PATTERN --output-line-width WIDTH --scanner MODE --packed --longest-orf --mmap"
+              << " --chunk-size SIZE --chunk-overlap OVERLAP --time --profile PROFILE_PATH]" << std::endl;
     std::cout << "    Default:" << std::endl <<
         "        LABEL_PATTERN = '%s | gene | frame=%d | LOC=[%d,%d]'" << std::endl <<
-        "        WIDTH = 70" << std::endl;
+        "        WIDTH = 70" << std::endl <<
+        "        MODE = linear (forward|linear|simd)" << std::endl <<
+        "        SIZE = 0 (read whole records)" << std::endl <<
+        "        OVERLAP = 300" << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -161,13 +510,53 @@ int main(int argc, char **argv)
         auto line_width_option = input.getCmdOption("--time");
         check_time = true;
     }
+    // check for --scanner option
+    gene::ScanMode scan_mode = gene::ScanMode::Linear;
+    if (input.cmdOptionExists("--scanner") &&
+        !gene::parseScanMode(input.getCmdOption("--scanner"), scan_mode))
+    {
+        std::cerr << "Invalid scanner mode" << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    // check for --packed option
+    bool packed = input.cmdOptionExists("--packed");
+    // check for --longest-orf option
+    bool longest = input.cmdOptionExists("--longest-orf");
+    // check for --chunk-size and --chunk-overlap option
+    size_t chunk_size = 0, chunk_overlap = 300;
+    if (input.cmdOptionExists("--chunk-size"))
+        std::istringstream(input.getCmdOption("--chunk-size")) >> chunk_size;
+    if (input.cmdOptionExists("--chunk-overlap"))
+        std::istringstream(input.getCmdOption("--chunk-overlap")) >> chunk_overlap;
+    // check for --mmap option
+    bool mapped = input.cmdOptionExists("--mmap");
+    // check for --profile option
+    std::string profile_file;
+    if (input.cmdOptionExists("--profile"))
+    {
+        profile_file = input.getCmdOption("--profile");
+        gene::profile::enable();
+    }
     auto start = std::chrono::high_resolution_clock::now();
-    auto result = finding_gene(input_file.c_str(), output_file.c_str(), pattern.c_str(),line_width);
+    auto result = chunk_size == 0
+        ? finding_gene(input_file.c_str(), output_file.c_str(), pattern.c_str(),line_width,
+                       scan_mode, packed, longest, mapped, check_time)
+        : finding_gene_chunked(input_file.c_str(), output_file.c_str(), pattern.c_str(),line_width,
+                               scan_mode, packed, longest, chunk_size, chunk_overlap, mapped);
     // Timing
     if (check_time) {
         auto finish = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed = finish - start;
         std::cout << elapsed.count() << std::endl;
     }
+    // Profile
+    if (!profile_file.empty())
+    {
+        std::ofstream profile_out(profile_file);
+        gene::profile::writeJson(profile_out, {gene::profile::snapshot()});
+        if (!profile_out)
+            std::cerr << "Failed to write profile " << profile_file << std::endl;
+    }
     return result;
 }
\ No newline at end of file
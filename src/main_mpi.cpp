@@ -1,8 +1,17 @@
 #include "./lib/Fasta.h"
+#include "./lib/FastaWriter.h"
 #include "./lib/InputParser.h"
 #include "./lib/orf_finder.h"
 #include "./lib/gene_judge.h"
+#include "./lib/JudgeContext.h"
+#include "./lib/range_collect.h"
+#include "./lib/MappedFasta.h"
+#include "./lib/SliceScanner.h"
+#include "./lib/mpi_gene_range.h"
+#include "./lib/Checkpoint.h"
+#include "./lib/Profile.h"
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <omp.h>
 #include <string>
@@ -11,56 +20,39 @@
 #include <sstream>
 #include <mpi.h>
 #include <chrono>
+#include <algorithm>
+#include <thread>
+#include <filesystem>
+#include <cstdlib>
+#include <sched.h>
 
 MPI_Datatype MPI_GENE_RANGE;
 
-/**
- * @brief C++11 version of sprintf
- *        Reference: https://stackoverflow.com/questions/2342162/
- * @tparam Args
- * @param format
- * @param args
- * @return std::string
- */
-template <typename... Args>
-std::string string_format(const std::string &format, Args... args)
-{
-    int size_s = std::snprintf(nullptr, 0, format.c_str(), args...) + 1; // Extra space for '\0'
-    if (size_s <= 0)
-    {
-        throw std::runtime_error("Error during formatting.");
-    }
-    auto size = static_cast<size_t>(size_s);
-    std::unique_ptr<char[]> buf(new char[size]);
-    std::snprintf(buf.get(), size, format.c_str(), args...);
-    return std::string(buf.get(), buf.get() + size - 1); // We don't want the '\0' inside
-}
-
 /**
  * @brief Get the gene object, take isGene function from dynamic linked lib.
+ *        ORFs are judged in batches of similar cost with the judge
+ *        context of sequence.
  *
  * @param orfs    vector that contains ORFS, to check if it is a gene.
- * @param seq     Sequence to judge.
+ * @param judge   Judge context of sequence to judge.
  * @param start   Index of start ORF object
  * @param end     Index of end ORF object.
  * @return std::vector<gene::GeneRange>
  */
 std::vector<gene::GeneRange> get_gene(
     const std::vector<gene::GeneRange> &orfs,
-    const Sequence &seq, size_t start, size_t end)
+    const gene::JudgeContext &judge, size_t start, size_t end)
 {
-    std::vector<gene::GeneRange> result;
-    result.resize(orfs.size());
-    std::atomic<size_t> resultIndex = 0;
-    #pragma omp parallel for
-    for (int64_t i = start; i < end; ++i)
-    {
-        auto resSeq = isGene(orfs[i], seq);
-        if (resSeq)
-            result[resultIndex++] = resSeq;
-    }
-    result.resize(resultIndex);
-    return result;
+    std::vector<gene::GeneRange> judged(end - start);
+    // Batches of about 256 ORFs on average, with similar judge cost
+    auto bounds = judge.splitBatches(
+        orfs.data() + start, end - start,
+        std::max<size_t>(omp_get_max_threads() * 16, (end - start) / 256));
+    #pragma omp parallel for schedule(dynamic)
+    for (int64_t b = 0; b < (int64_t)bounds.size() - 1; ++b)
+        judge.judge(&orfs[start + bounds[b]], bounds[b + 1] - bounds[b], &judged[bounds[b]]);
+    // Keep genes
+    return gene::compactRanges(judged);
 }
 
 /**
@@ -91,223 +83,556 @@ inline size_t get_job_start(size_t total_job_count, size_t mpi_rank, size_t mpi_
     return total_job_count / mpi_size * mpi_rank + additional;
 }
 
+// ORFs judged between two tests of pending messages
+const size_t JUDGE_PIECE = 1 << 14;
+
 /**
- * @brief Get the process rank that need more job
+ * @brief Balance judge cost of ORFs across processes, and judge them
+ *        while they move. ORFs are ordered by rank, and cost totals of
+ *        processes are shared by MPI_Allgather, so every process knows
+ *        the cost before each of its ORFs. An ORF goes to process i, if
+ *        the middle of its cost is in [total * i / size,
+ *        total * (i + 1) / size). Targets only grow along the order, so
+ *        every process sends a contiguous block to each process.
  *
- * @param job_counts
- * @param total_job
+ *        Counts are exchanged by MPI_Alltoall, then blocks are moved by
+ *        MPI_Isend and MPI_Irecv. The block a process keeps is judged at
+ *        once, in pieces, with a test of pending messages after every
+ *        piece, and a received block is judged as soon as it arrives.
+ *        Genes are returned in order of blocks, so their order is same
+ *        as judging balanced ORFs in one pass.
+ *
+ * @param ranges    ORFs of process
+ * @param judge     Judge context of sequence, that estimates cost
+ * @param mpi_rank
  * @param mpi_size
- * @return int
+ * @param comm      Communicator of processes
+ * @return std::vector<gene::GeneRange>     Genes of balanced ORFs
  */
-int get_need(unsigned long long *job_counts, size_t total_job, size_t mpi_size)
+std::vector<gene::GeneRange> balance_and_judge(const std::vector<gene::GeneRange> &ranges,
+                                               const gene::JudgeContext &judge,
+                                               int mpi_rank, int mpi_size,
+                                               MPI_Comm comm = MPI_COMM_WORLD)
 {
-    for (auto i = 0; i < mpi_size; ++i)
-        if (job_counts[i] < get_job_count(total_job, i, mpi_size))
-            return i;
-    return -1;
+    std::unique_ptr<gene::profile::Scope> exchange(new gene::profile::Scope(gene::profile::Balance));
+    std::vector<double> costs(ranges.size());
+    judge.cost(ranges.data(), ranges.size(), costs.data());
+    double local_cost = 0;
+    for (auto c : costs)
+        local_cost += c;
+    std::vector<double> totals(mpi_size);
+    MPI_Allgather(&local_cost, 1, MPI_DOUBLE, totals.data(), 1, MPI_DOUBLE, comm);
+    // Cost of ORFs before this process, and of all ORFs
+    double before = 0, total = 0;
+    for (int i = 0; i < mpi_size; ++i)
+    {
+        before += i < mpi_rank ? totals[i] : 0;
+        total += totals[i];
+    }
+    std::vector<int> send_counts(mpi_size, 0), send_displs(mpi_size, 0);
+    std::vector<int> recv_counts(mpi_size);
+    double sum = before;
+    for (auto c : costs)
+    {
+        double middle = sum + c / 2;
+        sum += c;
+        int target = total > 0 ? std::min<int>(mpi_size - 1, middle * mpi_size / total) : mpi_rank;
+        ++send_counts[target];
+    }
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, comm);
+    for (int i = 1; i < mpi_size; ++i)
+        send_displs[i] = send_displs[i - 1] + send_counts[i - 1];
+    // Blocks from other processes, and requests of moving blocks
+    std::vector<std::vector<gene::GeneRange>> blocks(mpi_size);
+    std::vector<MPI_Request> recvs(mpi_size, MPI_REQUEST_NULL), sends(mpi_size, MPI_REQUEST_NULL);
+    for (int i = 0; i < mpi_size; ++i)
+        if (i != mpi_rank && recv_counts[i] > 0)
+        {
+            blocks[i].resize(recv_counts[i]);
+            MPI_Irecv(blocks[i].data(), recv_counts[i], MPI_GENE_RANGE, i, 0, comm, &recvs[i]);
+        }
+    for (int i = 0; i < mpi_size; ++i)
+        if (i != mpi_rank && send_counts[i] > 0)
+        {
+            MPI_Isend(ranges.data() + send_displs[i], send_counts[i], MPI_GENE_RANGE, i, 0,
+                      comm, &sends[i]);
+            gene::profile::count(gene::profile::MessagesSent, 1);
+            gene::profile::count(gene::profile::BytesSent, send_counts[i] * sizeof(gene::GeneRange));
+        }
+    exchange.reset();
+    // Genes of block from each process
+    std::vector<std::vector<gene::GeneRange>> genes(mpi_size);
+    auto judge_arrived = [&](bool wait)
+    {
+        int i = MPI_UNDEFINED, arrived = 0;
+        if (wait)
+        {
+            gene::profile::Scope scope(gene::profile::Balance);
+            MPI_Waitany(mpi_size, recvs.data(), &i, MPI_STATUS_IGNORE);
+        }
+        else
+            MPI_Testany(mpi_size, recvs.data(), &i, &arrived, MPI_STATUS_IGNORE);
+        if (i == MPI_UNDEFINED)
+            return false;
+        genes[i] = get_gene(blocks[i], judge, 0, blocks[i].size());
+        blocks[i] = std::vector<gene::GeneRange>();
+        return true;
+    };
+    // Judge kept block, messages progress between pieces
+    size_t kept_start = send_displs[mpi_rank], kept_end = kept_start + send_counts[mpi_rank];
+    for (size_t start = kept_start; start < kept_end; start += JUDGE_PIECE)
+    {
+        auto piece = get_gene(ranges, judge, start, std::min(kept_end, start + JUDGE_PIECE));
+        genes[mpi_rank].insert(genes[mpi_rank].end(), piece.begin(), piece.end());
+        judge_arrived(false);
+    }
+    while (judge_arrived(true))
+        ;
+    {
+        gene::profile::Scope scope(gene::profile::Balance);
+        MPI_Waitall(mpi_size, sends.data(), MPI_STATUSES_IGNORE);
+    }
+    std::vector<gene::GeneRange> result;
+    for (auto &block : genes)
+        result.insert(result.end(), block.begin(), block.end());
+    return result;
 }
 
 /**
- * @brief Get the process rank that has too much more jobs
+ * @brief Write formatted records of all processes to file in rank order.
+ *        Offset of every process is an exclusive scan of sizes of their
+ *        records, and records are written by collective MPI-IO writes at
+ *        these offsets, so no process sends records to another.
  *
- * @param job_counts
- * @param total_job
- * @param mpi_size
- * @return int
+ * @param file
+ * @param out       Formatted records of process
+ * @param base      Offset of records of first process, offset after
+ *                  records of all processes after return
+ * @param mpi_rank
+ * @param comm      Communicator of processes, that opened file
  */
-int get_full(unsigned long long *job_counts, size_t total_job, size_t mpi_size)
+void write_records_at(MPI_File file, const FastaBuffer &out, MPI_Offset &base,
+                      int mpi_rank, MPI_Comm comm = MPI_COMM_WORLD)
 {
-    for (auto i = 0; i < mpi_size; ++i)
-        if (job_counts[i] > get_job_count(total_job, i, mpi_size))
-            return i;
-    return -1;
+    gene::profile::Scope scope(gene::profile::Write);
+    gene::profile::count(gene::profile::BytesWritten, out.size());
+    long long size = out.size(), before = 0, total = 0;
+    MPI_Exscan(&size, &before, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    // Result of exclusive scan is undefined on first process
+    if (mpi_rank == 0)
+        before = 0;
+    MPI_Allreduce(&size, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    // Every process takes part in the same number of writes of at most
+    // 1 GB, count of MPI_File_write_at_all is an int
+    const long long block = 1 << 30;
+    for (long long written = 0; written < total; written += block)
+    {
+        auto count = written < size ? std::min(block, size - written) : 0;
+        MPI_File_write_at_all(file, base + before + std::min(written, size),
+                              out.str().data() + std::min(written, size), (int)count,
+                              MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    base += total;
 }
 
 /**
- * @brief Send gene range to other process
+ * @brief Open output file on all processes, remove its content after
+ *        size bytes
  *
- * @param ranges
- * @param count
- * @param target
+ * @param output_filepath
+ * @param size      Size of saved output, 0 for a new output
+ * @param comm      Communicator of processes
+ * @return MPI_File
+ */
+MPI_File open_output(const char *output_filepath, MPI_Offset size, MPI_Comm comm = MPI_COMM_WORLD)
+{
+    MPI_File file;
+    MPI_File_open(comm, output_filepath, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                  MPI_INFO_NULL, &file);
+    MPI_File_set_size(file, size);
+    return file;
+}
+
+/**
+ * @brief Progress of output: the first records of input are saved, and
+ *        output has offset bytes. If checkpoint is set, progress is saved
+ *        to its manifest after every collective write.
  */
-void send_gene_range(std::vector<gene::GeneRange> &ranges, size_t count, int target)
+struct Progress
 {
-    // Copy gene range to buffer
-    for (size_t i = 0; i < count; ++i)
+    size_t records = 0;
+    MPI_Offset offset = 0;
+    const gene::Checkpoint *checkpoint = nullptr;
+
+    /**
+     * @brief Mark the first records as saved. Output is synced by all
+     *        processes, then main process saves manifest, so manifest
+     *        never points past data on disk.
+     *
+     * @param file
+     * @param records
+     * @param mpi_rank
+     */
+    void save(MPI_File file, size_t records, int mpi_rank)
     {
-        gene::GeneRange item = ranges.back();
-        MPI_Send(&item, 1, MPI_GENE_RANGE, target, 0, MPI_COMM_WORLD);
-        ranges.pop_back();
+        this->records = records;
+        if (this->checkpoint == nullptr)
+            return;
+        MPI_File_sync(file);
+        if (mpi_rank == 0 && !this->checkpoint->save(records, this->offset))
+            std::cerr << "Failed to save checkpoint " << this->checkpoint->getPath() << std::endl;
     }
-    // Send data in buffer to world
+};
+
+/**
+ * @brief Find genes of a record split by position across processes, and
+ *        format genes of process. ORFs are balanced by judge cost, so
+ *        every process formats a contiguous part of genes of record.
+ *
+ * @param seq
+ * @param print_pattern
+ * @param mpi_rank
+ * @param mpi_size
+ * @param line_width
+ * @param scan_mode
+ * @param packed
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param records       Formatted genes are appended to it
+ * @param comm          Communicator of processes
+ */
+void find_split_record(Sequence &seq, const char *print_pattern, int mpi_rank, int mpi_size,
+                       size_t line_width, gene::ScanMode scan_mode, bool packed, bool longest,
+                       FastaBuffer &records, MPI_Comm comm = MPI_COMM_WORLD)
+{
+    if (packed)
+        seq.pack();
+    // Slice [job_start, job_end) of strand of every frame, in codons, so
+    // slices keep phase of frames and every ORF is found once
+    const size_t l = seq.getSequence().length();
+    auto job_start = std::min(l, get_job_start((l + 2) / 3, mpi_rank, mpi_size) * 3);
+    auto job_end = std::min(l, get_job_start((l + 2) / 3, mpi_rank + 1, mpi_size) * 3);
     
+    std::vector<gene::GeneRange> local_orfs;
+    for (int frame=-3; frame<=3; ++frame) {
+        if (frame==0)
+            continue;
+        auto orfs = frame > 0
+            ? gene::getORFS(seq, frame, job_start, job_end, scan_mode)
+            : gene::getORFS(seq, frame, l - job_end, l - job_start, scan_mode);
+        // Longer ORF of a stop codon may start in slice of previous process,
+        // it is seen in the whole sequence
+        if (longest)
+            gene::keepLongestORFS(seq, frame, orfs);
+        // Store result to local orfs vector
+        if (local_orfs.capacity() < local_orfs.size() + orfs.size())
+            local_orfs.reserve(local_orfs.size() + orfs.size());
+        local_orfs.insert(local_orfs.end(), orfs.begin(), orfs.end());;
+    }
+    // Balancing ORFS by judge cost, and getting gene
+    gene::JudgeContext judge(seq);
+    auto gene_result = balance_and_judge(local_orfs, judge, mpi_rank, mpi_size, comm);
+    formatRecords(records, gene_result.size(), [&](size_t i, FastaBuffer &out)
+    {
+        out.appendLabel(print_pattern, seq.getLabel().c_str(),
+                        gene_result[i].start, gene_result[i].end);
+        out.appendBases(seq.getSequence().data() + gene_result[i].abs_start(),
+                        gene_result[i].length(), line_width);
+    });
 }
 
 /**
- * @brief Receive gene range from other process
+ * @brief Find genes of a whole record on this process alone, and format
+ *        them.
  *
- * @param ranges
- * @param count
- * @param target
+ * @param seq
+ * @param print_pattern
+ * @param line_width
+ * @param scan_mode
+ * @param packed
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param records       Formatted genes are appended to it
  */
-MPI_Status recv_gene_range(std::vector<gene::GeneRange> &ranges, size_t count, int target)
+void find_whole_record(Sequence &seq, const char *print_pattern, size_t line_width,
+                       gene::ScanMode scan_mode, bool packed, bool longest, FastaBuffer &records)
 {
-    MPI_Status s;
-    gene::GeneRange item;
-    for (size_t i = 0; i < count; ++i) {
-        MPI_Recv(&item, 1, MPI_GENE_RANGE, target, 0, MPI_COMM_WORLD, &s);
-        ranges.push_back(item);
+    if (packed)
+        seq.pack();
+    std::vector<gene::GeneRange> orfs;
+    for (int frame = -3; frame <= 3; ++frame)
+    {
+        if (frame == 0)
+            continue;
+        auto frame_orfs = gene::getORFS(seq, frame, 0, seq.getSequence().length(), scan_mode);
+        if (longest)
+            gene::keepLongestORFS(seq, frame, frame_orfs);
+        orfs.insert(orfs.end(), frame_orfs.begin(), frame_orfs.end());
     }
-    return s;
+    gene::JudgeContext judge(seq);
+    auto gene_result = get_gene(orfs, judge, 0, orfs.size());
+    formatRecords(records, gene_result.size(), [&](size_t i, FastaBuffer &out)
+    {
+        out.appendLabel(print_pattern, seq.getLabel().c_str(),
+                        gene_result[i].start, gene_result[i].end);
+        out.appendBases(seq.getSequence().data() + gene_result[i].abs_start(),
+                        gene_result[i].length(), line_width);
+    });
 }
 
 int findingGene(const char *input_filepath, const char *output_filepath,
-                const char *print_pattern, int mpi_rank, int mpi_size, size_t line_width = 70)
+                const char *print_pattern, int mpi_rank, int mpi_size, Progress &progress,
+                size_t line_width = 70,
+                gene::ScanMode scan_mode = gene::ScanMode::Linear, bool packed = false,
+                bool longest = false, bool mapped = false, MPI_Comm comm = MPI_COMM_WORLD)
 {
 
 
-    // Reading orfs from file
+    // Reading orfs from file, every process maps the file instead of parsing it
     Fasta f(input_filepath, std::ios::in);
-    for (auto seq = f.getNextSequence(); seq; seq = f.getNextSequence())
+    std::unique_ptr<MappedFasta> mf(mapped ? new MappedFasta(input_filepath) : nullptr);
+    size_t record = progress.records;
+    auto next_sequence = [&]()
+    { return mapped ? mf->getSequence(record++) : f.getNextSequence(); };
+    // Skip saved records
+    for (size_t i = 0; !mapped && i < progress.records && f.getNextSequence(); ++i)
+        ;
+    MPI_File f_out = open_output(output_filepath, progress.offset, comm);
+    size_t saved = progress.records;
+    for (auto seq = next_sequence(); seq; seq = next_sequence())
     {
-        auto job_start = get_job_start(seq.getSequence().length(),mpi_rank,mpi_size);
-        auto job_end = get_job_start(seq.getSequence().length(),mpi_rank+1,mpi_size);
-        
-        std::vector<gene::GeneRange> local_orfs;
-        for (int frame=-3; frame<=3; ++frame) {
-            if (frame==0)
-                continue;
-            auto orfs = gene::getORFS(seq, frame, job_start, job_end);
-            // Store result to local orfs vector
-            if (local_orfs.capacity() < local_orfs.size() + orfs.size())
-                local_orfs.reserve(local_orfs.size() + orfs.size());
-            local_orfs.insert(local_orfs.end(), orfs.begin(), orfs.end());;
-        }
-        // Balancing ORFS
-        unsigned long long job_count = local_orfs.size();
-        MPI_Allreduce(&job_count, &job_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
-        // If is main process allocate job
-        std::vector<unsigned long long> task_count;
-        std::vector<int> task_target;
-        if (mpi_rank == 0)
-        {
-            // Get job count from every sub node
-            unsigned long long job_counts[mpi_size];
-            job_counts[0] = local_orfs.size();
-            for (auto i = 1; i < mpi_size; ++i)
-            {
-                MPI_Status s;
-                MPI_Recv(&(job_counts[i]), 1, MPI_UNSIGNED_LONG_LONG, i, 0, MPI_COMM_WORLD, &s);
-            }
-            // Balancing nodes
-            auto send_node = get_full(job_counts, job_count, mpi_size);
-            auto recv_node = get_need(job_counts, job_count, mpi_size);
-            while (send_node != -1 || recv_node != -1)
-            {
-                size_t send_count = job_counts[send_node] - get_job_count(job_count, send_node, mpi_size);
-                size_t recv_count = get_job_count(job_count, recv_node, mpi_size) - job_counts[recv_node];
-                unsigned long long current_count = send_count < recv_count ? send_count : recv_count;
-
-                // Send count first and then send target node
-                if (send_node != 0)
-                {
-                    MPI_Send(&current_count, 1, MPI_UNSIGNED_LONG_LONG, send_node, 0, MPI_COMM_WORLD);
-                    MPI_Send(&recv_node, 1, MPI_INT, send_node, 0, MPI_COMM_WORLD);
-                } else {
-                    task_count.push_back(current_count);
-                    task_target.push_back(recv_node);
-                }
-                if (recv_node != 0)
-                {
-                    MPI_Send(&current_count, 1, MPI_UNSIGNED_LONG_LONG, recv_node, 0, MPI_COMM_WORLD);
-                    MPI_Send(&send_node, 1, MPI_INT, recv_node, 0, MPI_COMM_WORLD);
-                } else {
-                    task_count.push_back(current_count);
-                    task_target.push_back(send_node);
-                }
-                // Record balancing result
-                job_counts[send_node] -= current_count;
-                job_counts[recv_node] += current_count;
-                // Get next node
-                send_node = get_full(job_counts, job_count, mpi_size);
-                recv_node = get_need(job_counts, job_count, mpi_size);
-            }
-            job_count = job_counts[0];
-        }
-        else // If it is sub node
-        {
-            // Send current job count to main node for balancing
-            unsigned long long local_size = local_orfs.size();
-            MPI_Send(&local_size, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD);
+        // Save genes of every process at its offset of file
+        FastaBuffer records;
+        find_split_record(seq, print_pattern, mpi_rank, mpi_size, line_width, scan_mode, packed, longest,
+                          records, comm);
+        write_records_at(f_out, records, progress.offset, mpi_rank, comm);
+        progress.save(f_out, ++saved, mpi_rank);
+    }
+    MPI_File_close(&f_out);
+    f.close();
+    return 0;
+}
 
-            // Calculate target job count
-            auto addition_rank_max = job_count % mpi_size;
-            job_count = get_job_count(job_count, mpi_rank, mpi_size);
+// Bases of a group of small records, that are saved by one collective write
+const size_t MAX_GROUP_BASES = (size_t)256 << 20;
 
-            // Getting balancing target from main node. Then, getting job from sub node.
-            while (local_size != job_count)
-            {
-                unsigned long long current_count;
-                int target_node;
-                MPI_Status s;
-                MPI_Recv(&current_count, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD, &s);
-                MPI_Recv(&target_node, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &s);
-                task_count.push_back(current_count);
-                task_target.push_back(target_node);
-                if (local_size > job_count)
-                    local_size -= current_count;
-                else
-                    local_size += current_count;
-            }
+/**
+ * @brief Find genes with records distributed across processes. Records
+ *        are located by the index of input file. Records longer than
+ *        threshold are split by position across all processes. Other
+ *        records are grouped in runs between long records, and every
+ *        process takes a contiguous block of records of a run, weighted
+ *        by length. Processes find genes of their records alone, and
+ *        a run is saved by one collective write, so there is no
+ *        collective per small record.
+ *
+ * @param input_filepath
+ * @param output_filepath
+ * @param print_pattern
+ * @param mpi_rank
+ * @param mpi_size
+ * @param progress      Saved progress, it is updated after every write
+ * @param line_width
+ * @param scan_mode
+ * @param packed
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param mapped
+ * @param threshold     Records longer than it are split by position
+ * @param comm          Communicator of processes
+ * @return int
+ */
+int findingGeneByRecord(const char *input_filepath, const char *output_filepath,
+                        const char *print_pattern, int mpi_rank, int mpi_size, Progress &progress,
+                        size_t line_width, gene::ScanMode scan_mode, bool packed, bool longest,
+                        bool mapped, size_t threshold,
+                        MPI_Comm comm = MPI_COMM_WORLD)
+{
+    Fasta f(input_filepath, std::ios::in);
+    std::unique_ptr<MappedFasta> mf(mapped ? new MappedFasta(input_filepath) : nullptr);
+    // Main process writes .fai file, before other processes load it
+    if (!mapped && mpi_rank == 0)
+        f.getIndex();
+    if (!mapped)
+        MPI_Barrier(comm);
+    const auto &index = mapped ? mf->getIndex() : f.getIndex();
+    auto read_record = [&](size_t record)
+    {
+        return mapped ? mf->getSequence(record)
+                      : f.getRegion(record, 0, index[record].length);
+    };
+    MPI_File f_out = open_output(output_filepath, progress.offset, comm);
+    for (size_t record = progress.records; record < index.size();)
+    {
+        FastaBuffer records;
+        if (index[record].length > threshold)
+        {
+            auto seq = read_record(record++);
+            find_split_record(seq, print_pattern, mpi_rank, mpi_size, line_width, scan_mode, packed, longest,
+                          records, comm);
+            write_records_at(f_out, records, progress.offset, mpi_rank, comm);
+            progress.save(f_out, record, mpi_rank);
+            continue;
         }
-        // Sync Job
-        unsigned long long current_count;
-        int target_node;
-        while (!task_count.empty()) {
-            current_count = task_count.back();
-            target_node = task_target.back();
-            if (local_orfs.size() > job_count)
-                send_gene_range(local_orfs, current_count, target_node);
-            else
-                recv_gene_range(local_orfs, current_count, target_node);
-            task_count.pop_back();
-            task_target.pop_back();
+        // Run of short records [record, end)
+        size_t end = record, total = 0;
+        while (end < index.size() && index[end].length <= threshold && total < MAX_GROUP_BASES)
+            total += index[end++].length;
+        // Record goes to the process that has the middle of its bases
+        size_t before = 0;
+        for (; record < end; ++record)
+        {
+            auto length = index[record].length;
+            int target = total > 0
+                             ? std::min<size_t>(mpi_size - 1, (before * 2 + length) * mpi_size / (total * 2))
+                             : 0;
+            before += length;
+            if (target != mpi_rank)
+                continue;
+            auto seq = read_record(record);
+            find_whole_record(seq, print_pattern, line_width, scan_mode, packed, longest, records);
         }
-        // Getting gene
-        auto gene_result = get_gene(local_orfs, seq, 0, local_orfs.size());
-        // Get total gene count
-        job_count = gene_result.size();
-        MPI_Allreduce(&job_count, &job_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        write_records_at(f_out, records, progress.offset, mpi_rank, comm);
+        progress.save(f_out, record, mpi_rank);
+    }
+    MPI_File_close(&f_out);
+    f.close();
+    return 0;
+}
 
-        // Gethering gene to main node
-        if (mpi_rank == 0) {
-            recv_gene_range(gene_result,job_count-gene_result.size(),MPI_ANY_SOURCE);
-        } else {
-            send_gene_range(gene_result,gene_result.size(),0);
-        }
-                   
-        // If it is main node, save result to file
-        if (mpi_rank == 0)
+/**
+ * @brief Find genes with every process reading only its slice of each
+ *        record. Records are located by the .fai index of input file,
+ *        which is built by main process if it is missing or outdated.
+ *        Every process judges ORFs that start in its slice, and saves
+ *        genes of its slice from its window.
+ *
+ * @param input_filepath
+ * @param output_filepath
+ * @param print_pattern
+ * @param mpi_rank
+ * @param mpi_size
+ * @param progress      Saved progress, it is updated after every write
+ * @param line_width
+ * @param scan_mode
+ * @param packed        Use 2-bit packed representation of sequences
+ * @param longest       Judge only the longest ORF of every stop codon
+ * @param overlap       Bases kept around ORF for gene judge
+ * @param comm          Communicator of processes
+ * @return int
+ */
+int findingGeneSliced(const char *input_filepath, const char *output_filepath,
+                      const char *print_pattern, int mpi_rank, int mpi_size, Progress &progress,
+                      size_t line_width, gene::ScanMode scan_mode, bool packed, bool longest, size_t overlap,
+                      MPI_Comm comm = MPI_COMM_WORLD)
+{
+    Fasta f(input_filepath, std::ios::in);
+    // Main process writes .fai file, before other processes load it
+    if (mpi_rank == 0)
+        f.getIndex();
+    MPI_Barrier(comm);
+    const auto &index = f.getIndex();
+    MPI_File f_out = open_output(output_filepath, progress.offset, comm);
+    for (size_t record = progress.records; record < index.size(); ++record)
+    {
+        auto length = index[record].length;
+        auto job_start = get_job_start(length, mpi_rank, mpi_size);
+        auto job_end = get_job_start(length, mpi_rank + 1, mpi_size);
+        // Read region of slice, until it covers every ORF of slice
+        gene::SliceScanner scanner(length, job_start, job_end, overlap, scan_mode, packed, longest);
+        while (!scanner.push(f.getRegion(record, scanner.getRegionStart(), scanner.getRegionEnd())))
+            ;
+        const auto &window = scanner.getWindow();
+        auto offset = scanner.getOffset();
+        std::vector<gene::GeneRange> local_orfs;
+        for (int frame = -3; frame <= 3; ++frame)
         {
-            Fasta f_out(output_filepath, std::ios::out);
-            for (unsigned long long i = 0; i < job_count; ++i)
-            {
-                Sequence seq_out(
-                    string_format(print_pattern, seq.getLabel().c_str(),
-                                  gene_result[i].start,
-                                  gene_result[i].end),
-                    seq.getSequence().substr(
-                        gene_result[i].abs_start(),
-                        gene_result[i].length()));
-                f_out.write(seq_out, line_width);
-            }
-            f_out.close();
+            if (frame == 0)
+                continue;
+            auto orfs = scanner.getORFS(frame);
+            if (longest)
+                gene::keepLongestORFS(window, frame, orfs);
+            local_orfs.insert(local_orfs.end(), orfs.begin(), orfs.end());
         }
+        // Getting gene, in window coordinates
+        gene::JudgeContext judge(window);
+        auto gene_result = get_gene(local_orfs, judge, 0, local_orfs.size());
+        // Window covers every gene of slice, so every process saves its
+        // genes at its offset of file
+        FastaBuffer records;
+        formatRecords(records, gene_result.size(), [&](size_t i, FastaBuffer &out)
+        {
+            out.appendLabel(print_pattern, index[record].label.c_str(),
+                            gene_result[i].start + offset, gene_result[i].end + offset);
+            out.appendBases(window.getSequence().data() + gene_result[i].abs_start(),
+                            gene_result[i].length(), line_width);
+        });
+        write_records_at(f_out, records, progress.offset, mpi_rank, comm);
+        progress.save(f_out, record + 1, mpi_rank);
     }
+    MPI_File_close(&f_out);
     f.close();
     return 0;
 }
 
+/**
+ * @brief Run gene finding with one process per node. Processes of a node
+ *        are grouped by MPI_Comm_split_type, and the first process of
+ *        every node (node leader) takes the CPU affinity of all processes
+ *        of its node, and runs one OpenMP thread per CPU of it (or
+ *        OMP_NUM_THREADS per process, if it is set). Threads inherit the
+ *        affinity of leader, so cores of bound processes are used as
+ *        well. Leaders read records and exchange ORFs
+ *        and genes with each other, so a node holds one copy of sequence
+ *        and its threads share ORFs in memory. Other processes sleep
+ *        until their leader finishes, so they do not poll a core.
+ *
+ * @tparam Run      Callable as run(comm, rank, size) on leaders, with
+ *                  communicator of leaders
+ * @param run
+ * @return int
+ */
+template <typename Run>
+int run_per_node(const Run &run)
+{
+    int world_rank, node_rank, node_size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm node_comm, leader_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, world_rank, &leader_comm);
+    // Leader gets CPUs of all processes of node
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    bool affinity = sched_getaffinity(0, sizeof(cpus), &cpus) == 0;
+    std::vector<cpu_set_t> node_cpus(node_rank == 0 ? node_size : 0);
+    MPI_Gather(&cpus, sizeof(cpus), MPI_BYTE, node_cpus.data(), sizeof(cpus), MPI_BYTE, 0, node_comm);
+    int result = 0;
+    if (leader_comm != MPI_COMM_NULL)
+    {
+        int leader_rank, leader_size;
+        MPI_Comm_rank(leader_comm, &leader_rank);
+        MPI_Comm_size(leader_comm, &leader_size);
+        for (auto &other : node_cpus)
+            CPU_OR(&cpus, &cpus, &other);
+        // Threads are created later, and inherit the affinity of leader
+        if (affinity)
+            affinity = sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+        int threads = affinity ? CPU_COUNT(&cpus) : omp_get_num_procs();
+        if (std::getenv("OMP_NUM_THREADS") != nullptr)
+            threads = std::max(1, omp_get_max_threads()) * node_size;
+        omp_set_num_threads(threads);
+        result = run(leader_comm, leader_rank, leader_size);
+        MPI_Comm_free(&leader_comm);
+    }
+    // Wait for leader of node, sleep between tests
+    MPI_Request request;
+    MPI_Ibarrier(node_comm, &request);
+    int done = 0;
+    while (MPI_Test(&request, &done, MPI_STATUS_IGNORE) == MPI_SUCCESS && !done)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    MPI_Comm_free(&node_comm);
+    return result;
+}
+
 /**
  * @brief Print usage of program
  *
@@ -317,10 +642,15 @@ void print_usage(const char *prog)
 {
     std::cout << "Usage: " << prog << " --input INPUT_FILE_PATH"
               << " --output OUTPUT_FILE_PATH"
-              << " [--pattern LABEL_PATTERN --output-line-width WIDTH]" << std::endl;
+              << " [--pattern LABEL_PATTERN --output-line-width WIDTH --scanner MODE --packed --longest-orf --mmap"
+              << " --fai --slice-overlap OVERLAP --by-record --split-threshold SIZE --hybrid"
+              << " --checkpoint --resume --profile PROFILE_PATH]" << std::endl;
     std::cout << "    Default:" << std::endl
               << "        LABEL_PATTERN = '%s | gene | LOC=[%d,%d]'" << std::endl
-              << "        WIDTH = 70" << std::endl;
+              << "        WIDTH = 70" << std::endl
+              << "        MODE = linear (forward|linear|simd)" << std::endl
+              << "        OVERLAP = 300" << std::endl
+              << "        SIZE = 1000000" << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -371,24 +701,113 @@ int main(int argc, char **argv)
         auto line_width_option = input.getCmdOption("--time");
         check_time = true;
     }
-    
+    // check for --scanner option
+    gene::ScanMode scan_mode = gene::ScanMode::Linear;
+    if (input.cmdOptionExists("--scanner") &&
+        !gene::parseScanMode(input.getCmdOption("--scanner"), scan_mode))
+    {
+        if (rank == 0)
+            print_usage(argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+    // check for --packed option
+    bool packed = input.cmdOptionExists("--packed");
+    // check for --longest-orf option
+    bool longest = input.cmdOptionExists("--longest-orf");
+    // check for --mmap option
+    bool mapped = input.cmdOptionExists("--mmap");
+    // check for --fai and --slice-overlap option
+    bool sliced = input.cmdOptionExists("--fai");
+    size_t slice_overlap = 300;
+    if (input.cmdOptionExists("--slice-overlap"))
+        std::istringstream(input.getCmdOption("--slice-overlap")) >> slice_overlap;
+
+    // check for --by-record and --split-threshold option
+    bool by_record = input.cmdOptionExists("--by-record");
+    size_t split_threshold = 1000000;
+    if (input.cmdOptionExists("--split-threshold"))
+        std::istringstream(input.getCmdOption("--split-threshold")) >> split_threshold;
+    // check for --hybrid option
+    bool hybrid = input.cmdOptionExists("--hybrid");
+    // check for --checkpoint and --resume option
+    bool resume = input.cmdOptionExists("--resume");
+    bool checkpointed = resume || input.cmdOptionExists("--checkpoint");
+    // Input and options that change output or order of records, a
+    // manifest of another input or other options is not used
+    std::ostringstream fingerprint;
+    std::error_code size_error, time_error;
+    fingerprint << "size=" << std::filesystem::file_size(input_file, size_error)
+                << " mtime=" << std::filesystem::last_write_time(input_file, time_error).time_since_epoch().count()
+                << " width=" << line_width << " scanner=" << int(scan_mode) << " packed=" << packed
+                << " longest=" << longest << " mmap=" << mapped << " fai=" << sliced
+                << " overlap=" << slice_overlap << " by_record=" << by_record
+                << " split=" << split_threshold << " hybrid=" << hybrid << " pattern=" << pattern;
+    gene::Checkpoint checkpoint(output_file, fingerprint.str());
+    Progress progress;
+    if (checkpointed)
+        progress.checkpoint = &checkpoint;
+    // Main process loads saved progress, and shares it
+    if (resume)
+    {
+        unsigned long long saved[2] = {0, 0};
+        size_t records = 0;
+        uint64_t offset = 0;
+        if (rank == 0 && checkpoint.load(records, offset))
+        {
+            saved[0] = records;
+            saved[1] = offset;
+            std::cerr << "Resume after " << records << " records, " << offset << " bytes" << std::endl;
+        }
+        else if (rank == 0)
+            std::cerr << "No checkpoint of this input and options, start from beginning" << std::endl;
+        MPI_Bcast(saved, 2, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+        progress.records = saved[0];
+        progress.offset = saved[1];
+    }
+
+    // check for --profile option
+    std::string profile_file;
+    if (input.cmdOptionExists("--profile"))
+    {
+        profile_file = input.getCmdOption("--profile");
+        gene::profile::enable();
+    }
+
     auto start = std::chrono::high_resolution_clock::now();
     // Create type for gene range
-    const int nitems = 3;
-    int blocklengths[3] = {1, 1, 1};
-    MPI_Datatype types[3] = {MPI_UNSIGNED_LONG_LONG, MPI_UNSIGNED_LONG_LONG, MPI_UINT8_T};
-    MPI_Datatype tmp_type;
-    MPI_Aint offsets[3];
-    MPI_Aint lb, extent;
-    offsets[0] = offsetof(gene::GeneRange, start);
-    offsets[1] = offsetof(gene::GeneRange, end);
-    offsets[2] = offsetof(gene::GeneRange, frame);
-    MPI_Type_create_struct(nitems, blocklengths, offsets, types, &tmp_type);
-    MPI_Type_get_extent( tmp_type, &lb, &extent );
-    MPI_Type_create_resized( tmp_type, lb, extent, &MPI_GENE_RANGE );
-    MPI_Type_commit(&MPI_GENE_RANGE);
+    MPI_GENE_RANGE = gene::createGeneRangeType();
     // Find gene
-    auto result = findingGene(input_file.c_str(), output_file.c_str(), pattern.c_str(), rank, size, line_width);
+    auto find = [&](MPI_Comm comm, int comm_rank, int comm_size)
+    {
+        return sliced
+            ? findingGeneSliced(input_file.c_str(), output_file.c_str(), pattern.c_str(), comm_rank, comm_size,
+                                progress, line_width, scan_mode, packed, longest, slice_overlap, comm)
+            : by_record
+            ? findingGeneByRecord(input_file.c_str(), output_file.c_str(), pattern.c_str(), comm_rank, comm_size,
+                                  progress, line_width, scan_mode, packed, longest, mapped, split_threshold, comm)
+            : findingGene(input_file.c_str(), output_file.c_str(), pattern.c_str(), comm_rank, comm_size,
+                          progress, line_width, scan_mode, packed, longest, mapped, comm);
+    };
+    auto result = hybrid ? run_per_node(find) : find(MPI_COMM_WORLD, rank, size);
+    // Output is closed by all processes, a finished run needs no manifest
+    if (checkpointed && result == 0 && rank == 0)
+        checkpoint.remove();
+    // Main process gathers profiles of all processes and writes them
+    if (!profile_file.empty())
+    {
+        const int fields = sizeof(gene::profile::Snapshot) / sizeof(double);
+        auto local = gene::profile::snapshot();
+        std::vector<gene::profile::Snapshot> profiles(rank == 0 ? size : 0);
+        MPI_Gather(&local, fields, MPI_DOUBLE, profiles.data(), fields, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        if (rank == 0)
+        {
+            std::ofstream profile_out(profile_file);
+            gene::profile::writeJson(profile_out, profiles);
+            if (!profile_out)
+                std::cerr << "Failed to write profile " << profile_file << std::endl;
+        }
+    }
     MPI_Finalize();
     // Timing
     if (check_time && rank==0) {